@@ -7,6 +7,11 @@
 
 #define TITLE   "Pianobar"
 
+/* strdup and friends on POSIX systems (libpiano benchmark) */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 /* Visual C++ name restrict differently */
 #ifdef _WIN32
 #define restrict __restrict
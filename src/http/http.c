@@ -27,6 +27,9 @@ THE SOFTWARE.
 #include <winhttp.h>
 #pragma comment(lib, "winhttp.lib")
 
+/* smallest response buffer, most responses fit */
+#define HTTP_RESPONSE_MIN (16*1024)
+
 struct _http_t {
 	HINTERNET		session;
 	HINTERNET		connection;
@@ -37,6 +40,7 @@ struct _http_t {
 	wchar_t*		proxyUsername;
 	wchar_t*		proxyPassword;
 	char*			error;
+	HttpStats_t		stats;
 };
 
 static char* HttpToString(const wchar_t* wideString, size_t size);
@@ -94,6 +98,15 @@ static bool HttpCreateConnection (http_t http, unsigned int timeOut) {
 		timeOut * 1000,  // send time-out
 		timeOut * 1000); // receive time-out
 
+#ifdef WINHTTP_OPTION_DECOMPRESSION
+	{
+		/* gzip/deflate, transparently decoded; Windows 8.1 and later */
+		DWORD decompression = WINHTTP_DECOMPRESSION_FLAG_ALL;
+		WinHttpSetOption(http->session, WINHTTP_OPTION_DECOMPRESSION,
+			&decompression, sizeof(decompression));
+	}
+#endif
+
 	http->connection = WinHttpConnect(
 		http->session,
 		http->endpoint,
@@ -327,6 +340,39 @@ bool HttpSetProxy (http_t http, const char* url) {
 	return true;
 }
 
+bool HttpSetCaBundle (http_t http, const char* path) {
+	/* WinHTTP verifies against the system certificate store */
+	return true;
+}
+
+/*	make room for size bytes (plus NUL) of response data, doubling the buffer
+ *	unless exact to keep the number of reallocations for large responses low
+ */
+static bool HttpReserveResponse (http_t http, PianoRequest_t* request, size_t size, bool exact) {
+	size_t capacity = size + 1;
+	char* responseData;
+
+	if (capacity <= request->responseDataCapacity)
+		return true;
+
+	if (!exact) {
+		capacity = request->responseDataCapacity > HTTP_RESPONSE_MIN ?
+			request->responseDataCapacity : HTTP_RESPONSE_MIN;
+		while (capacity < size + 1)
+			capacity *= 2;
+	}
+
+	/* buffer is kept by the request for later calls */
+	responseData = realloc(request->responseData, capacity);
+	if (responseData == NULL) {
+		HttpSetLastError (http, "Out of memory");
+		return false;
+	}
+	request->responseData = responseData;
+	request->responseDataCapacity = capacity;
+	return true;
+}
+
 bool HttpRequest(http_t http, PianoRequest_t * const request) {
 	HINTERNET handle = NULL;
 	wchar_t* wideQuery = NULL;
@@ -334,6 +380,9 @@ bool HttpRequest(http_t http, PianoRequest_t * const request) {
 	bool complete = false;
 	int retryLimit = 3;
 	size_t responseDataSize;
+	DWORD contentLength, contentLengthSize;
+
+	++http->stats.requests;
 
 	wideQuery = HttpToWideString(request->urlPath, -1);
 	WINHTTP_SAFE_DONE(wideQuery != NULL);
@@ -481,6 +530,20 @@ bool HttpRequest(http_t http, PianoRequest_t * const request) {
 	}
 
 	responseDataSize = 0;
+	contentLength = 0;
+	contentLengthSize = sizeof(contentLength);
+	if (WinHttpQueryHeaders(handle,
+			WINHTTP_QUERY_CONTENT_LENGTH | WINHTTP_QUERY_FLAG_NUMBER,
+			WINHTTP_HEADER_NAME_BY_INDEX,
+			&contentLength, &contentLengthSize, WINHTTP_NO_HEADER_INDEX)) {
+		/* whole body fits, no reallocation while reading */
+		if (!HttpReserveResponse (http, request, contentLength, true))
+			goto done;
+	}
+	else if (!HttpReserveResponse (http, request, 0, false))
+		goto done;
+	/* no leftovers from an earlier response */
+	request->responseData[0] = 0;
 	while (retryLimit > 0)
 	{
 		DWORD bytesLeft;
@@ -497,7 +560,8 @@ bool HttpRequest(http_t http, PianoRequest_t * const request) {
 			break;
 
 		responseDataSize += bytesAvailable;
-		request->responseData = realloc(request->responseData, responseDataSize + 1);
+		if (!HttpReserveResponse (http, request, responseDataSize, false))
+			goto done;
 
 		writePtr = request->responseData + responseDataSize - bytesAvailable;
 		writePtr[bytesAvailable] = 0;
@@ -530,6 +594,11 @@ bool HttpRequest(http_t http, PianoRequest_t * const request) {
 	}
 
 	complete = true;
+	request->responseDataLength = responseDataSize;
+	request->responseDataExpected = responseDataSize;
+	/* WinHTTP does not tell the size on the wire */
+	http->stats.lastDecoded = responseDataSize;
+	http->stats.decoded += responseDataSize;
 
 	HttpSetLastError (http, NULL);
 
@@ -541,3 +610,18 @@ done:
 const char* HttpGetError(http_t http) {
 	return http->error;
 }
+
+bool HttpRequestBegin (http_t http, PianoRequest_t * const request) {
+	/* WinHTTP hands out the whole body at once */
+	return HttpRequest (http, request);
+}
+
+bool HttpRequestReceive (http_t http, PianoRequest_t * const request, bool * const done) {
+	*done = true;
+	return true;
+}
+
+void HttpGetStats (http_t http, HttpStats_t* stats) {
+	/* WinHTTP keeps its connections and TLS sessions to itself */
+	*stats = http->stats;
+}
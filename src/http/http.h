@@ -32,12 +32,37 @@ THE SOFTWARE.
 
 typedef struct _http_t *http_t;
 
+/* transport counters, connection, handshake and transfer numbers stay zero
+ * if the transport does not know them */
+typedef struct {
+	unsigned long requests;
+	/* connections opened and pooled connections used again */
+	unsigned long connects, reused;
+	/* pooled connections found closed by the server while sending */
+	unsigned long redials;
+	/* completed TLS handshakes, those resuming an earlier session and
+	 * their total duration in seconds */
+	unsigned long handshakes, resumed;
+	double handshakeTime;
+	/* response body bytes as transferred and after content decoding, in
+	 * total and for the latest request */
+	unsigned long long received, decoded;
+	size_t lastReceived, lastDecoded;
+} HttpStats_t;
+
 bool HttpInit (http_t*, const char*, const char*, unsigned int);
 void HttpDestroy (http_t);
 
 bool HttpSetAutoProxy (http_t, const char*);
 bool HttpSetProxy(http_t, const char*);
+bool HttpSetCaBundle (http_t, const char*);
 
 bool HttpRequest (http_t, PianoRequest_t * const);
+/* send request and receive response headers, the body follows piece by
+ * piece with HttpRequestReceive, which sets done once there is nothing
+ * left to append */
+bool HttpRequestBegin (http_t, PianoRequest_t * const);
+bool HttpRequestReceive (http_t, PianoRequest_t * const, bool * const);
 const char* HttpGetError (http_t);
+void HttpGetStats (http_t, HttpStats_t*);
 
@@ -0,0 +1,1306 @@
+/*
+Copyright (c) 2015
+	Michał Cichoń <thedmd@interia.pl>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* http.h on top of non-blocking BSD sockets and OpenSSL, for platforms
+ * without WinHTTP. Behaves like http.c: up to three attempts per request,
+ * retrying on timeouts, connection failures, 5xx and 407 responses. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "config.h"
+#include "http.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <zlib.h>
+
+#ifndef MSG_NOSIGNAL
+/* SIGPIPE is ignored anyway */
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifndef HTTP_PLAIN_PORT
+/* overridden by the transport checks, which cannot listen on port 80 */
+#define HTTP_PLAIN_PORT "80"
+#endif
+#define HTTP_RETRIES 3
+/* idle keep-alive connections kept around, shared by both schemes */
+#define HTTP_POOL_SIZE 4
+/* seconds, servers tend to drop idle connections after a minute */
+#define HTTP_IDLE_TIMEOUT 30
+/* smallest response buffer, most responses fit */
+#define HTTP_RESPONSE_MIN (16*1024)
+
+/* outcome of a network operation */
+typedef enum {
+	HTTP_OK,
+	/* timeout, refused connection, 5xx, …: worth another attempt */
+	HTTP_RETRY,
+	/* pooled connection was closed by the server, try a new one */
+	HTTP_REDIAL,
+	HTTP_FAIL,
+} HttpResult_t;
+
+typedef struct {
+	int		fd;
+	SSL*	ssl;
+	/* scheme of the request this connection was opened for */
+	bool	secure;
+	/* monotonic seconds the connection was put into the pool */
+	time_t	idleSince;
+	/* TLS protocol error, the session must not be resumed */
+	bool	broken;
+	/* buffered input */
+	char	buf[16*1024];
+	size_t	start, end;
+} HttpConnection_t;
+
+/*	response status line and headers
+ */
+typedef struct {
+	unsigned int status;
+	char statusText[128];
+	bool chunked;
+	bool haveLength;
+	unsigned long long length;
+	/* server keeps the connection open */
+	bool keepAlive;
+	/* gzip or deflate content encoding */
+	bool compressed;
+} HttpResponse_t;
+
+/*	response body being received
+ */
+typedef struct {
+	PianoRequest_t* request;
+	/* decoded bytes in responseData */
+	size_t length;
+	/* body bytes as they came over the wire */
+	size_t received;
+	/* content decoder, NULL for identity encoding */
+	z_stream* inflate;
+	bool inflateDone;
+	/* raw deflate, for servers that send deflate without zlib header */
+	bool rawDeflate;
+} HttpBody_t;
+
+/*	request whose response is being received, see HttpRequestBegin
+ */
+typedef struct {
+	/* NULL if no transfer is going on */
+	HttpConnection_t* connection;
+	HttpResponse_t response;
+	HttpBody_t body;
+	z_stream stream;
+	/* body bytes left in the current chunk, or in the whole body */
+	unsigned long long remaining;
+	/* a chunk was read, its terminating CRLF is next */
+	bool inChunks;
+	bool done;
+	/* why the last transfer failed, HTTP_OK if it did not */
+	HttpResult_t status;
+} HttpTransfer_t;
+
+struct _http_t {
+	char*			endpoint;
+	char*			securePort;
+	/* per connect/send/receive, seconds */
+	unsigned int	timeOut;
+	/* proxy for all requests, no proxy if proxyHost is NULL */
+	char*			proxyHost;
+	char*			proxyPort;
+	/* base64 of user:password, NULL if the proxy needs no credentials */
+	char*			proxyAuth;
+	SSL_CTX*		tls;
+	char*			error;
+	/* warm connections to endpoint (or proxy), empty slots are NULL */
+	HttpConnection_t*	idle[HTTP_POOL_SIZE];
+	/* latest session ticket/id from endpoint, to resume the next handshake */
+	SSL_SESSION*	session;
+	HttpTransfer_t	transfer;
+	HttpStats_t		stats;
+};
+
+static void HttpSetLastError (http_t http, const char* message) {
+	free(http->error);
+	http->error = NULL;
+
+	if (message)
+		http->error = strdup(message);
+}
+
+static void HttpSetLastErrorf (http_t http, const char* format, ...)
+		__attribute__((format(printf, 2, 3)));
+
+static void HttpSetLastErrorf (http_t http, const char* format, ...) {
+	char message[512];
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	HttpSetLastError (http, message);
+}
+
+/*	set error from the OpenSSL error queue
+ */
+static void HttpSetLastErrorFromTls (http_t http, const char* what) {
+	const unsigned long error = ERR_get_error();
+	char message[256];
+
+	if (error != 0) {
+		ERR_error_string_n(error, message, sizeof(message));
+		HttpSetLastErrorf (http, "%s: %s", what, message);
+	} else if (errno != 0) {
+		HttpSetLastErrorf (http, "%s: %s", what, strerror(errno));
+	} else {
+		HttpSetLastError (http, what);
+	}
+	ERR_clear_error();
+}
+
+/*	remember the newest session the server handed out, called by OpenSSL
+ *	after the handshake (TLS 1.2) or on a NewSessionTicket (TLS 1.3)
+ */
+static int HttpNewSession (SSL* ssl, SSL_SESSION* session) {
+	http_t http = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+
+	if (http->session)
+		SSL_SESSION_free(http->session);
+	http->session = session;
+
+	/* keeping the reference */
+	return 1;
+}
+
+bool HttpInit(http_t* http, const char* endpoint, const char* securePort, unsigned int timeOut) {
+	http_t out = calloc(1, sizeof(struct _http_t));
+	if (!out)
+		return false;
+
+	/* a peer closing the connection must not kill us while writing */
+	signal(SIGPIPE, SIG_IGN);
+
+	out->endpoint   = strdup(endpoint);
+	out->securePort = strdup(securePort);
+	out->timeOut    = timeOut;
+	out->tls        = SSL_CTX_new(TLS_client_method());
+	if (!out->endpoint || !out->securePort || !out->tls) {
+		HttpDestroy (out);
+		return false;
+	}
+
+	SSL_CTX_set_min_proto_version(out->tls, TLS1_2_VERSION);
+	SSL_CTX_set_verify(out->tls, SSL_VERIFY_PEER, NULL);
+	SSL_CTX_set_default_verify_paths(out->tls);
+	/* only one server, so a single session is kept in http_t instead of
+	 * OpenSSL's cache */
+	SSL_CTX_set_app_data(out->tls, out);
+	SSL_CTX_set_session_cache_mode(out->tls,
+		SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	SSL_CTX_sess_set_new_cb(out->tls, HttpNewSession);
+
+	*http = out;
+	return true;
+}
+
+static void HttpClearProxy (http_t http) {
+	free(http->proxyHost);
+	free(http->proxyPort);
+	free(http->proxyAuth);
+	http->proxyHost = NULL;
+	http->proxyPort = NULL;
+	http->proxyAuth = NULL;
+}
+
+static void HttpPoolFlush (http_t http);
+
+static void HttpTransferEnd (http_t http, HttpResult_t result);
+
+void HttpDestroy(http_t http) {
+	if (http) {
+		HttpTransferEnd (http, HTTP_FAIL);
+		HttpPoolFlush (http);
+		free(http->endpoint);
+		free(http->securePort);
+		HttpClearProxy (http);
+		if (http->session)
+			SSL_SESSION_free(http->session);
+		if (http->tls)
+			SSL_CTX_free(http->tls);
+		free(http->error);
+	}
+	free(http);
+}
+
+bool HttpSetCaBundle (http_t http, const char* path) {
+	if (!SSL_CTX_load_verify_locations(http->tls, path, NULL)) {
+		HttpSetLastErrorFromTls (http, "Cannot load CA bundle");
+		return false;
+	}
+	return true;
+}
+
+bool HttpSetAutoProxy (http_t http, const char* url) {
+	(void) url;
+
+	HttpClearProxy (http);
+	HttpSetLastError (http, "Proxy auto-configuration is not supported");
+	return false;
+}
+
+/*	decode %XX escapes in place
+ */
+static void HttpUrlDecodeInplace (char* url) {
+	char* output = url;
+
+	for (const char* input = url; *input != '\0'; ++input) {
+		if (input[0] == '%' && isxdigit((unsigned char) input[1]) &&
+				isxdigit((unsigned char) input[2])) {
+			const char hex[3] = { input[1], input[2], 0 };
+			*output++ = (char) strtol(hex, NULL, 16);
+			input += 2;
+		}
+		else
+			*output++ = *input;
+	}
+	*output = '\0';
+}
+
+static char* HttpBase64Encode (const char* input) {
+	static const char alphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	const unsigned char* in = (const unsigned char*) input;
+	const size_t size = strlen(input);
+	char* output = malloc((size + 2) / 3 * 4 + 1);
+	char* out = output;
+
+	if (!output)
+		return NULL;
+
+	for (size_t i = 0; i < size; i += 3) {
+		const unsigned long block = (unsigned long) in[i] << 16 |
+			(i + 1 < size ? (unsigned long) in[i + 1] << 8 : 0) |
+			(i + 2 < size ? in[i + 2] : 0);
+		*out++ = alphabet[(block >> 18) & 0x3f];
+		*out++ = alphabet[(block >> 12) & 0x3f];
+		*out++ = i + 1 < size ? alphabet[(block >> 6) & 0x3f] : '=';
+		*out++ = i + 2 < size ? alphabet[block & 0x3f] : '=';
+	}
+	*out = '\0';
+
+	return output;
+}
+
+/*	parse [scheme://][user[:password]@]host[:port][/…]
+ */
+bool HttpSetProxy (http_t http, const char* url) {
+	const char* scheme = strstr(url, "://");
+	const char* authority = scheme ? scheme + 3 : url;
+	const size_t authorityLength = strcspn(authority, "/");
+	char* proxy = strndup(authority, authorityLength);
+	char* host = proxy;
+	char* credentials = NULL;
+	char* port = NULL;
+	char* at;
+
+	if (!proxy)
+		return false;
+
+	if ((at = strrchr(proxy, '@')) != NULL) {
+		char* password;
+
+		*at = '\0';
+		host = at + 1;
+		if ((password = strchr(proxy, ':')) != NULL)
+			*password++ = '\0';
+		HttpUrlDecodeInplace (proxy);
+		if (password)
+			HttpUrlDecodeInplace (password);
+
+		const size_t size = strlen(proxy) + 1 + (password ? strlen(password) : 0) + 1;
+		if ((credentials = malloc(size)) != NULL)
+			snprintf(credentials, size, "%s:%s", proxy, password ? password : "");
+	}
+
+	if (host[0] == '[') {
+		/* [v6 address]:port */
+		char* end = strchr(host, ']');
+		if (end) {
+			*end = '\0';
+			++host;
+			if (end[1] == ':')
+				port = end + 2;
+		}
+	}
+	else if ((port = strchr(host, ':')) != NULL)
+		*port++ = '\0';
+
+	if (host[0] == '\0') {
+		free(credentials);
+		free(proxy);
+		HttpSetLastError (http, "Invalid proxy");
+		return false;
+	}
+
+	HttpClearProxy (http);
+	/* pooled connections go to the old proxy */
+	HttpPoolFlush (http);
+	http->proxyHost = strdup(host);
+	http->proxyPort = strdup(port && *port ? port : HTTP_PLAIN_PORT);
+	http->proxyAuth = credentials ? HttpBase64Encode (credentials) : NULL;
+
+	free(credentials);
+	free(proxy);
+	return http->proxyHost != NULL && http->proxyPort != NULL;
+}
+
+/*	wait until the connection is ready for events
+ *	@return HTTP_RETRY on timeout
+ */
+static HttpResult_t HttpWait (http_t http, const HttpConnection_t* connection, short events) {
+	struct pollfd pfd = { .fd = connection->fd, .events = events };
+	int ret;
+
+	do {
+		ret = poll(&pfd, 1, http->timeOut * 1000);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret == 0) {
+		HttpSetLastError (http, "Timeout");
+		return HTTP_RETRY;
+	}
+	if (ret < 0) {
+		HttpSetLastErrorf (http, "poll: %s", strerror(errno));
+		return HTTP_FAIL;
+	}
+	return HTTP_OK;
+}
+
+/*	wait for whatever OpenSSL needs to continue after a failed call
+ */
+static HttpResult_t HttpWaitTls (http_t http, HttpConnection_t* connection, int ret, const char* what) {
+	const int error = SSL_get_error(connection->ssl, ret);
+
+	switch (error) {
+		case SSL_ERROR_WANT_READ:
+			return HttpWait (http, connection, POLLIN);
+
+		case SSL_ERROR_WANT_WRITE:
+			return HttpWait (http, connection, POLLOUT);
+
+		default:
+			HttpSetLastErrorFromTls (http, what);
+			connection->broken = error == SSL_ERROR_SSL;
+			/* connection reset and the like */
+			return HTTP_RETRY;
+	}
+}
+
+static void HttpClose (HttpConnection_t* connection) {
+	if (connection->ssl) {
+		/* OpenSSL refuses to resume sessions of connections that were not
+		 * shut down, which covers servers closing idle connections and
+		 * resets as well; only protocol errors should do that */
+		if (!connection->broken)
+			SSL_set_shutdown(connection->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+		SSL_free(connection->ssl);
+		connection->ssl = NULL;
+	}
+	if (connection->fd >= 0) {
+		close(connection->fd);
+		connection->fd = -1;
+	}
+	connection->start = connection->end = 0;
+	connection->broken = false;
+}
+
+static time_t HttpNow (void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec;
+}
+
+/*	monotonic time in seconds, for measurements
+ */
+static double HttpClock (void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*	check that an idle connection is still open: it must not be readable,
+ *	neither a close from the server nor unrequested data
+ */
+static bool HttpIsAlive (const HttpConnection_t* connection) {
+	struct pollfd pfd = { .fd = connection->fd, .events = POLLIN };
+
+	return (connection->ssl == NULL || SSL_pending(connection->ssl) == 0) &&
+		poll(&pfd, 1, 0) == 0;
+}
+
+static void HttpPoolDrop (http_t http, size_t slot) {
+	HttpClose (http->idle[slot]);
+	free(http->idle[slot]);
+	http->idle[slot] = NULL;
+}
+
+static void HttpPoolFlush (http_t http) {
+	for (size_t i = 0; i < HTTP_POOL_SIZE; ++i)
+		if (http->idle[i])
+			HttpPoolDrop (http, i);
+}
+
+/*	take a warm connection for the scheme out of the pool, dropping expired
+ *	and dead ones on the way
+ *	@return connection or NULL if there is none
+ */
+static HttpConnection_t* HttpPoolGet (http_t http, bool secure) {
+	const time_t now = HttpNow ();
+	HttpConnection_t* found = NULL;
+
+	for (size_t i = 0; i < HTTP_POOL_SIZE; ++i) {
+		HttpConnection_t* const connection = http->idle[i];
+		if (!connection)
+			continue;
+
+		if (now - connection->idleSince > HTTP_IDLE_TIMEOUT || !HttpIsAlive (connection))
+			HttpPoolDrop (http, i);
+		else if (!found && connection->secure == secure) {
+			found = connection;
+			http->idle[i] = NULL;
+		}
+	}
+
+	return found;
+}
+
+/*	return a connection to the pool, replacing the one idle for the longest
+ *	time if it is full
+ */
+static void HttpPoolPut (http_t http, HttpConnection_t* connection) {
+	size_t slot = 0;
+
+	for (size_t i = 0; i < HTTP_POOL_SIZE; ++i) {
+		if (!http->idle[i]) {
+			slot = i;
+			break;
+		}
+		if (http->idle[i]->idleSince < http->idle[slot]->idleSince)
+			slot = i;
+	}
+
+	if (http->idle[slot])
+		HttpPoolDrop (http, slot);
+	connection->idleSince = HttpNow ();
+	http->idle[slot] = connection;
+}
+
+/*	open tcp connection, trying every address of host
+ */
+static HttpResult_t HttpConnect (http_t http, HttpConnection_t* connection, const char* host, const char* port) {
+	struct addrinfo hints, *addresses;
+	HttpResult_t result = HTTP_RETRY;
+	int error;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+
+	if ((error = getaddrinfo(host, port, &hints, &addresses)) != 0) {
+		HttpSetLastErrorf (http, "Cannot resolve %s: %s", host, gai_strerror(error));
+		/* like ERROR_WINHTTP_NAME_NOT_RESOLVED */
+		return HTTP_RETRY;
+	}
+
+	HttpSetLastErrorf (http, "Cannot connect to %s:%s", host, port);
+	for (struct addrinfo* address = addresses; address != NULL; address = address->ai_next) {
+		connection->fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (connection->fd < 0)
+			continue;
+		fcntl(connection->fd, F_SETFD, FD_CLOEXEC);
+		fcntl(connection->fd, F_SETFL, fcntl(connection->fd, F_GETFL) | O_NONBLOCK);
+		/* request head and body are separate writes, do not let the body
+		 * wait for the ack of the head on a reused connection */
+		setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &(int) { 1 }, sizeof(int));
+
+		if (connect(connection->fd, address->ai_addr, address->ai_addrlen) == 0) {
+			result = HTTP_OK;
+			break;
+		}
+
+		if (errno == EINPROGRESS) {
+			const HttpResult_t wait = HttpWait (http, connection, POLLOUT);
+			int socketError = 0;
+			socklen_t size = sizeof(socketError);
+
+			if (wait == HTTP_FAIL) {
+				result = HTTP_FAIL;
+				break;
+			}
+			if (wait == HTTP_OK &&
+					getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &socketError, &size) == 0 &&
+					socketError == 0) {
+				result = HTTP_OK;
+				break;
+			}
+			errno = wait == HTTP_OK ? socketError : ETIMEDOUT;
+		}
+
+		HttpSetLastErrorf (http, "Cannot connect to %s:%s: %s", host, port, strerror(errno));
+		close(connection->fd);
+		connection->fd = -1;
+	}
+
+	freeaddrinfo(addresses);
+	return result;
+}
+
+static HttpResult_t HttpWrite (http_t http, HttpConnection_t* connection, const char* data, size_t size) {
+	while (size > 0) {
+		HttpResult_t result;
+		ssize_t written;
+
+		if (connection->ssl) {
+			const int ret = SSL_write(connection->ssl, data, (int) size);
+			if (ret <= 0) {
+				if ((result = HttpWaitTls (http, connection, ret, "Send failed")) != HTTP_OK)
+					return result;
+				continue;
+			}
+			written = ret;
+		}
+		else {
+			written = send(connection->fd, data, size, MSG_NOSIGNAL);
+			if (written < 0) {
+				if (errno == EINTR)
+					continue;
+				if (errno != EAGAIN && errno != EWOULDBLOCK) {
+					HttpSetLastErrorf (http, "Send failed: %s", strerror(errno));
+					return HTTP_RETRY;
+				}
+				if ((result = HttpWait (http, connection, POLLOUT)) != HTTP_OK)
+					return result;
+				continue;
+			}
+		}
+
+		data += written;
+		size -= written;
+	}
+
+	return HTTP_OK;
+}
+
+/*	receive whatever is available, waiting for at least one byte
+ *	@param bytes received, 0 if the peer closed the connection
+ */
+static HttpResult_t HttpReceive (http_t http, HttpConnection_t* connection, char* data, size_t size,
+		size_t* received) {
+	*received = 0;
+
+	for (;;) {
+		HttpResult_t result;
+
+		if (connection->ssl) {
+			const int ret = SSL_read_ex(connection->ssl, data, size, received);
+			if (ret > 0)
+				return HTTP_OK;
+			if (SSL_get_error(connection->ssl, ret) == SSL_ERROR_ZERO_RETURN)
+				return HTTP_OK;
+			if (SSL_get_error(connection->ssl, ret) == SSL_ERROR_SYSCALL && ERR_peek_error() == 0)
+				/* closed without close_notify, common for http servers */
+				return HTTP_OK;
+			if ((result = HttpWaitTls (http, connection, ret, "Receive failed")) != HTTP_OK)
+				return result;
+		}
+		else {
+			const ssize_t ret = recv(connection->fd, data, size, 0);
+			if (ret >= 0) {
+				*received = ret;
+				return HTTP_OK;
+			}
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				HttpSetLastErrorf (http, "Receive failed: %s", strerror(errno));
+				return HTTP_RETRY;
+			}
+			if ((result = HttpWait (http, connection, POLLIN)) != HTTP_OK)
+				return result;
+		}
+	}
+}
+
+/*	refill input buffer
+ *	@param set to true if the peer closed the connection
+ */
+static HttpResult_t HttpFill (http_t http, HttpConnection_t* connection, bool* eof) {
+	if (connection->start == connection->end)
+		connection->start = connection->end = 0;
+	if (connection->end == sizeof(connection->buf)) {
+		/* make room, only happens for overlong header lines */
+		if (connection->start == 0) {
+			HttpSetLastError (http, "Response header too long");
+			return HTTP_FAIL;
+		}
+		memmove(connection->buf, connection->buf + connection->start,
+			connection->end - connection->start);
+		connection->end -= connection->start;
+		connection->start = 0;
+	}
+
+	size_t received;
+	const HttpResult_t result = HttpReceive (http, connection, connection->buf + connection->end,
+		sizeof(connection->buf) - connection->end, &received);
+	connection->end += received;
+	*eof = result == HTTP_OK && received == 0;
+	return result;
+}
+
+/*	read CRLF-terminated line, the terminator is removed
+ *	@return line inside the connection buffer, valid until the next read
+ */
+static HttpResult_t HttpReadLine (http_t http, HttpConnection_t* connection, char** line) {
+	size_t scanned = connection->start;
+
+	for (;;) {
+		char* const begin = connection->buf + connection->start;
+		char* const newline = memchr(connection->buf + scanned, '\n', connection->end - scanned);
+		if (newline) {
+			*newline = '\0';
+			if (newline > begin && newline[-1] == '\r')
+				newline[-1] = '\0';
+			connection->start = newline + 1 - connection->buf;
+			*line = begin;
+			return HTTP_OK;
+		}
+
+		const size_t consumed = connection->end - connection->start;
+		bool eof;
+		const HttpResult_t result = HttpFill (http, connection, &eof);
+		if (result != HTTP_OK)
+			return result;
+		if (eof) {
+			HttpSetLastError (http, "Connection closed");
+			return HTTP_RETRY;
+		}
+		scanned = connection->start + consumed;
+	}
+}
+
+static bool HttpResizeResponse (http_t http, PianoRequest_t* request, size_t capacity) {
+	/* buffer is kept by the request for later calls */
+	char* responseData = realloc(request->responseData, capacity);
+	if (!responseData) {
+		HttpSetLastError (http, "Out of memory");
+		return false;
+	}
+	request->responseData = responseData;
+	request->responseDataCapacity = capacity;
+	return true;
+}
+
+/*	make room for size more bytes (plus NUL) of response data, doubling the
+ *	buffer to keep the number of reallocations for large responses low
+ */
+static bool HttpReserveResponse (http_t http, PianoRequest_t* request, size_t length, size_t size) {
+	if (length + size + 1 > request->responseDataCapacity) {
+		size_t capacity = request->responseDataCapacity > HTTP_RESPONSE_MIN ?
+			request->responseDataCapacity : HTTP_RESPONSE_MIN;
+		while (capacity < length + size + 1)
+			capacity *= 2;
+		return HttpResizeResponse (http, request, capacity);
+	}
+	return true;
+}
+
+static HttpResult_t HttpReadHeaders (http_t http, HttpConnection_t* connection, HttpResponse_t* response) {
+	HttpResult_t result;
+	char* line;
+
+	memset(response, 0, sizeof(*response));
+
+	if ((result = HttpReadLine (http, connection, &line)) != HTTP_OK)
+		return result;
+	unsigned int major, minor;
+	int textOffset = 0;
+	if (sscanf(line, "HTTP/%u.%u %3u %n", &major, &minor, &response->status, &textOffset) < 3) {
+		HttpSetLastError (http, "Invalid response");
+		return HTTP_FAIL;
+	}
+	/* persistent by default since 1.1 */
+	response->keepAlive = major > 1 || (major == 1 && minor >= 1);
+	snprintf(response->statusText, sizeof(response->statusText), "%s",
+		textOffset > 0 ? line + textOffset : "");
+
+	for (;;) {
+		if ((result = HttpReadLine (http, connection, &line)) != HTTP_OK)
+			return result;
+		if (*line == '\0')
+			return HTTP_OK;
+
+		char* value = strchr(line, ':');
+		if (!value)
+			continue;
+		*value++ = '\0';
+		value += strspn(value, " \t");
+
+		if (strcasecmp(line, "Content-Length") == 0) {
+			response->haveLength = true;
+			response->length = strtoull(value, NULL, 10);
+		}
+		else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+			/* chunked is always the last coding */
+			const size_t size = strlen(value);
+			response->chunked = size >= 7 && strcasecmp(value + size - 7, "chunked") == 0;
+		}
+		else if (strcasecmp(line, "Content-Encoding") == 0) {
+			if (strcasecmp(value, "gzip") == 0 || strcasecmp(value, "x-gzip") == 0 ||
+					strcasecmp(value, "deflate") == 0)
+				response->compressed = true;
+			else if (*value != '\0' && strcasecmp(value, "identity") != 0) {
+				HttpSetLastErrorf (http, "Unsupported content encoding %s", value);
+				return HTTP_FAIL;
+			}
+		}
+		else if (strcasecmp(line, "Connection") == 0)
+			response->keepAlive = strcasecmp(value, "keep-alive") == 0 ||
+				(response->keepAlive && strcasecmp(value, "close") != 0);
+	}
+}
+
+/*	append body bytes to the response, decoding them if necessary
+ */
+static HttpResult_t HttpBodyAppend (http_t http, HttpBody_t* body, const char* data, size_t size) {
+	PianoRequest_t* const request = body->request;
+
+	body->received += size;
+
+	if (!body->inflate) {
+		if (!HttpReserveResponse (http, request, body->length, size))
+			return HTTP_FAIL;
+		memcpy(request->responseData + body->length, data, size);
+		body->length += size;
+		request->responseData[body->length] = '\0';
+		request->responseDataLength = body->length;
+		return HTTP_OK;
+	}
+
+	z_stream* const stream = body->inflate;
+	stream->next_in  = (Bytef*) data;
+	stream->avail_in = (uInt) size;
+
+	while (stream->avail_in > 0 && !body->inflateDone) {
+		/* json compresses well, guess generously */
+		if (!HttpReserveResponse (http, request, body->length, size * 4))
+			return HTTP_FAIL;
+		stream->next_out  = (Bytef*) request->responseData + body->length;
+		stream->avail_out = (uInt) (request->responseDataCapacity - body->length - 1);
+
+		const int ret = inflate(stream, Z_NO_FLUSH);
+		body->length = (char*) stream->next_out - request->responseData;
+		request->responseData[body->length] = '\0';
+		request->responseDataLength = body->length;
+
+		if (ret == Z_STREAM_END)
+			/* anything after the stream is ignored */
+			body->inflateDone = true;
+		else if (ret == Z_DATA_ERROR && !body->rawDeflate && body->received == size) {
+			/* no zlib header, try again as raw deflate */
+			body->rawDeflate = true;
+			stream->next_in  = (Bytef*) data;
+			stream->avail_in = (uInt) size;
+			if (inflateReset2(stream, -MAX_WBITS) != Z_OK)
+				break;
+		}
+		else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+			HttpSetLastErrorf (http, "Invalid compressed response: %s",
+				stream->msg ? stream->msg : "unknown error");
+			return HTTP_FAIL;
+		}
+	}
+
+	return HTTP_OK;
+}
+
+/*	read the next chunk header, skipping the end of the previous chunk
+ */
+static HttpResult_t HttpChunkBegin (http_t http, HttpTransfer_t* transfer) {
+	HttpConnection_t* const connection = transfer->connection;
+	HttpResult_t result;
+	char* line;
+	char* end;
+
+	if (transfer->inChunks &&
+			(result = HttpReadLine (http, connection, &line)) != HTTP_OK)
+		return result;
+	transfer->inChunks = true;
+
+	if ((result = HttpReadLine (http, connection, &line)) != HTTP_OK)
+		return result;
+	errno = 0;
+	const unsigned long long chunkSize = strtoull(line, &end, 16);
+	if (end == line || errno != 0 || (*end != '\0' && *end != ';' && *end != ' ')) {
+		HttpSetLastError (http, "Invalid chunk");
+		return HTTP_FAIL;
+	}
+
+	if (chunkSize == 0) {
+		/* skip trailers */
+		do {
+			if ((result = HttpReadLine (http, connection, &line)) != HTTP_OK)
+				return result;
+		} while (*line != '\0');
+		transfer->done = true;
+	}
+	transfer->remaining = chunkSize;
+	return HTTP_OK;
+}
+
+/*	receive the next piece of the response body, sets transfer->done once it
+ *	is complete
+ */
+static HttpResult_t HttpBodyStep (http_t http, HttpTransfer_t* transfer) {
+	HttpConnection_t* const connection = transfer->connection;
+	HttpBody_t* const body = &transfer->body;
+	PianoRequest_t* const request = body->request;
+	/* reading until the server closes the connection */
+	const bool untilEof = !transfer->response.chunked && !transfer->response.haveLength;
+	HttpResult_t result;
+
+	if (transfer->response.chunked && transfer->remaining == 0) {
+		if ((result = HttpChunkBegin (http, transfer)) != HTTP_OK)
+			return result;
+	}
+
+	if (!transfer->done && connection->start == connection->end) {
+		if (!body->inflate && transfer->remaining >= sizeof(connection->buf)) {
+			/* bulk of a large body: skip the connection buffer and receive
+			 * straight into the response, never beyond the body's end */
+			size_t received;
+			if (!HttpReserveResponse (http, request, body->length, sizeof(connection->buf)))
+				return HTTP_FAIL;
+			size_t space = request->responseDataCapacity - body->length - 1;
+			if (space > transfer->remaining)
+				space = transfer->remaining;
+			if ((result = HttpReceive (http, connection, request->responseData + body->length,
+					space, &received)) != HTTP_OK)
+				return result;
+			if (received == 0 && untilEof)
+				transfer->done = true;
+			else if (received == 0) {
+				HttpSetLastError (http, "Incomplete response data");
+				return HTTP_RETRY;
+			}
+			body->length += received;
+			body->received += received;
+			request->responseData[body->length] = '\0';
+			request->responseDataLength = body->length;
+			transfer->remaining -= received;
+		}
+		else {
+			bool eof;
+			if ((result = HttpFill (http, connection, &eof)) != HTTP_OK)
+				return result;
+			if (eof && untilEof)
+				transfer->done = true;
+			else if (eof) {
+				HttpSetLastError (http, "Incomplete response data");
+				return HTTP_RETRY;
+			}
+		}
+	}
+
+	if (!transfer->done) {
+		size_t available = connection->end - connection->start;
+		if (available > transfer->remaining)
+			available = transfer->remaining;
+		if ((result = HttpBodyAppend (http, body, connection->buf + connection->start, available)) != HTTP_OK)
+			return result;
+		connection->start += available;
+		transfer->remaining -= available;
+	}
+
+	if (!transfer->response.chunked && transfer->remaining == 0)
+		transfer->done = true;
+
+	if (transfer->done && body->inflate && !body->inflateDone) {
+		HttpSetLastError (http, "Incomplete response data");
+		return HTTP_RETRY;
+	}
+	return HTTP_OK;
+}
+
+/*	set up tls on a connected socket, verifying the certificate for host
+ */
+static HttpResult_t HttpStartTls (http_t http, HttpConnection_t* connection, const char* host) {
+	if ((connection->ssl = SSL_new(http->tls)) == NULL ||
+			!SSL_set_fd(connection->ssl, connection->fd) ||
+			!SSL_set_tlsext_host_name(connection->ssl, host) ||
+			!SSL_set1_host(connection->ssl, host)) {
+		HttpSetLastErrorFromTls (http, "TLS setup failed");
+		return HTTP_FAIL;
+	}
+	/* falls back to a full handshake if the server does not accept it */
+	if (http->session)
+		SSL_set_session(connection->ssl, http->session);
+
+	const double start = HttpClock ();
+	for (;;) {
+		const int ret = SSL_connect(connection->ssl);
+		if (ret == 1) {
+			++http->stats.handshakes;
+			if (SSL_session_reused(connection->ssl))
+				++http->stats.resumed;
+			http->stats.handshakeTime += HttpClock () - start;
+			return HTTP_OK;
+		}
+
+		const long verify = SSL_get_verify_result(connection->ssl);
+		if (verify != X509_V_OK) {
+			HttpSetLastErrorf (http, "TLS certificate verification failed: %s",
+				X509_verify_cert_error_string(verify));
+			return HTTP_FAIL;
+		}
+
+		const HttpResult_t result = HttpWaitTls (http, connection, ret, "TLS handshake failed");
+		if (result != HTTP_OK)
+			return result;
+	}
+}
+
+/*	open tunnel through the proxy with CONNECT
+ */
+static HttpResult_t HttpProxyConnect (http_t http, HttpConnection_t* connection, const char* port) {
+	char head[1024];
+	HttpResponse_t response;
+	HttpResult_t result;
+
+	const int size = snprintf(head, sizeof(head),
+		"CONNECT %s:%s HTTP/1.1\r\n"
+		"Host: %s:%s\r\n"
+		"%s%s%s"
+		"\r\n",
+		http->endpoint, port, http->endpoint, port,
+		http->proxyAuth ? "Proxy-Authorization: Basic " : "",
+		http->proxyAuth ? http->proxyAuth : "",
+		http->proxyAuth ? "\r\n" : "");
+	if (size < 0 || (size_t) size >= sizeof(head)) {
+		HttpSetLastError (http, "Proxy request too long");
+		return HTTP_FAIL;
+	}
+
+	if ((result = HttpWrite (http, connection, head, size)) != HTTP_OK ||
+			(result = HttpReadHeaders (http, connection, &response)) != HTTP_OK)
+		return result;
+
+	if (response.status == 407 || (response.status >= 500 && response.status <= 599)) {
+		HttpSetLastError (http, response.statusText);
+		return HTTP_RETRY;
+	}
+	if (response.status < 200 || response.status > 299) {
+		HttpSetLastErrorf (http, "Proxy refused connection: %u %s", response.status,
+			response.statusText);
+		return HTTP_FAIL;
+	}
+	if (connection->start != connection->end) {
+		HttpSetLastError (http, "Unexpected data from proxy");
+		return HTTP_FAIL;
+	}
+
+	return HTTP_OK;
+}
+
+/*	finish the current transfer, the connection is kept for later requests
+ *	if the response was read completely
+ */
+static void HttpTransferEnd (http_t http, HttpResult_t result) {
+	HttpTransfer_t* const transfer = &http->transfer;
+	HttpConnection_t* const connection = transfer->connection;
+
+	if (!connection)
+		return;
+
+	if (transfer->body.inflate)
+		inflateEnd(transfer->body.inflate);
+
+	http->stats.lastReceived = transfer->body.received;
+	http->stats.lastDecoded  = transfer->body.length;
+	http->stats.received += transfer->body.received;
+	http->stats.decoded  += transfer->body.length;
+
+	if (result == HTTP_OK && transfer->done && transfer->response.keepAlive &&
+			connection->start == connection->end)
+		HttpPoolPut (http, connection);
+	else {
+		HttpClose (connection);
+		free(connection);
+	}
+
+	transfer->connection = NULL;
+	transfer->status = result;
+}
+
+/*	one attempt: connect unless the connection is warm already, send request
+ *	and receive the response headers
+ */
+static HttpResult_t HttpTransferStart (http_t http, HttpConnection_t* connection, PianoRequest_t* request) {
+	HttpTransfer_t* const transfer = &http->transfer;
+	HttpResponse_t* const response = &transfer->response;
+	const char* const port = request->secure ? http->securePort : HTTP_PLAIN_PORT;
+	const bool viaProxy = http->proxyHost != NULL;
+	const bool reused = connection->fd >= 0;
+	HttpResult_t result;
+	char head[2048];
+
+	memset(transfer, 0, sizeof(*transfer));
+	transfer->connection = connection;
+	transfer->body.request = request;
+
+	if (!reused) {
+		result = viaProxy ?
+			HttpConnect (http, connection, http->proxyHost, http->proxyPort) :
+			HttpConnect (http, connection, http->endpoint, port);
+		if (result != HTTP_OK)
+			return result;
+
+		if (request->secure) {
+			if ((viaProxy && (result = HttpProxyConnect (http, connection, port)) != HTTP_OK) ||
+					(result = HttpStartTls (http, connection, http->endpoint)) != HTTP_OK)
+				return result;
+		}
+		connection->secure = request->secure;
+		++http->stats.connects;
+	}
+	else
+		++http->stats.reused;
+
+	/* plain requests through a proxy need the absolute uri */
+	const bool absolute = viaProxy && !request->secure;
+	const size_t postDataSize = strlen(request->postData);
+	const int size = snprintf(head, sizeof(head),
+		"POST %s%s%s HTTP/1.1\r\n"
+		"Host: %s\r\n"
+		"User-Agent: " PACKAGE "/" VERSION "\r\n"
+		"Content-Type: text/plain\r\n"
+		"Content-Length: %zu\r\n"
+		"Accept-Encoding: gzip, deflate\r\n"
+		"%s%s%s"
+		"\r\n",
+		absolute ? "http://" : "", absolute ? http->endpoint : "",
+		request->urlPath, http->endpoint, postDataSize,
+		absolute && http->proxyAuth ? "Proxy-Authorization: Basic " : "",
+		absolute && http->proxyAuth ? http->proxyAuth : "",
+		absolute && http->proxyAuth ? "\r\n" : "");
+	if (size < 0 || (size_t) size >= sizeof(head)) {
+		HttpSetLastError (http, "Request too long");
+		return HTTP_FAIL;
+	}
+
+	if ((result = HttpWrite (http, connection, head, size)) != HTTP_OK ||
+			(result = HttpWrite (http, connection, request->postData, postDataSize)) != HTTP_OK ||
+			(result = HttpReadHeaders (http, connection, response)) != HTTP_OK)
+		/* a server closing an idle connection races with our request; nothing
+		 * has been answered yet, so it is safe to send again */
+		return reused && result == HTTP_RETRY ? HTTP_REDIAL : result;
+
+	if (response->status == 407 || (response->status >= 500 && response->status <= 599)) {
+		HttpSetLastError (http, response->statusText);
+		return HTTP_RETRY;
+	}
+
+	if (response->compressed) {
+		/* zlib or gzip header */
+		if (inflateInit2(&transfer->stream, MAX_WBITS + 32) != Z_OK) {
+			HttpSetLastError (http, "Out of memory");
+			return HTTP_FAIL;
+		}
+		transfer->body.inflate = &transfer->stream;
+	}
+
+	if (!response->compressed && response->haveLength &&
+			response->length + 1 > request->responseDataCapacity) {
+		/* exact fit, the size is known */
+		if (!HttpResizeResponse (http, request, response->length + 1))
+			return HTTP_FAIL;
+	}
+	else if (!HttpReserveResponse (http, request, 0, 0))
+		return HTTP_FAIL;
+	/* no leftovers from an earlier response */
+	request->responseData[0] = '\0';
+	request->responseDataLength = 0;
+	/* inflated size is unknown */
+	request->responseDataExpected = !response->compressed && response->haveLength ?
+		response->length : 0;
+
+	if (response->haveLength && !response->chunked)
+		transfer->remaining = response->length;
+	else if (!response->chunked) {
+		/* body ends with the connection */
+		transfer->remaining = ULLONG_MAX;
+		response->keepAlive = false;
+	}
+	if (response->haveLength && !response->chunked && response->length == 0)
+		transfer->done = true;
+
+	return HTTP_OK;
+}
+
+/*	start transfer, retrying up to *attempts times
+ */
+static bool HttpTransferBegin (http_t http, PianoRequest_t* request, int* attempts) {
+	HttpResult_t result = HTTP_FAIL;
+
+	/* an unfinished transfer is given up */
+	HttpTransferEnd (http, HTTP_FAIL);
+
+	while (*attempts > 0) {
+		HttpConnection_t* connection = HttpPoolGet (http, request->secure);
+
+		if (!connection) {
+			if ((connection = malloc(sizeof(HttpConnection_t))) == NULL) {
+				HttpSetLastError (http, "Out of memory");
+				return false;
+			}
+			connection->fd     = -1;
+			connection->ssl    = NULL;
+			connection->start  = connection->end = 0;
+			connection->broken = false;
+		}
+
+		result = HttpTransferStart (http, connection, request);
+		if (result == HTTP_OK)
+			return true;
+		HttpTransferEnd (http, result);
+
+		if (result == HTTP_REDIAL)
+			/* does not count as an attempt, the pool runs dry eventually */
+			++http->stats.redials;
+		else if (result == HTTP_RETRY)
+			--*attempts;
+		else
+			return false;
+	}
+
+	HttpSetLastError (http, "Maximum retries count exceeded");
+	return false;
+}
+
+bool HttpRequestBegin (http_t http, PianoRequest_t * const request) {
+	int attempts = HTTP_RETRIES;
+
+	++http->stats.requests;
+
+	if (!HttpTransferBegin (http, request, &attempts))
+		return false;
+
+	HttpSetLastError (http, NULL);
+	return true;
+}
+
+bool HttpRequestReceive (http_t http, PianoRequest_t * const request, bool * const done) {
+	HttpTransfer_t* const transfer = &http->transfer;
+
+	*done = false;
+
+	if (!transfer->connection) {
+		/* finished, or failed */
+		*done = transfer->status == HTTP_OK;
+		return *done;
+	}
+
+	assert(transfer->body.request == request);
+	const size_t length = transfer->body.length;
+	while (!transfer->done && transfer->body.length == length) {
+		const HttpResult_t result = HttpBodyStep (http, transfer);
+		if (result != HTTP_OK) {
+			HttpTransferEnd (http, result);
+			return false;
+		}
+	}
+
+	if (transfer->done) {
+		HttpTransferEnd (http, HTTP_OK);
+		/* the caller has not seen the last piece yet, done is reported by
+		 * the next call */
+		*done = transfer->body.length == length;
+	}
+	return true;
+}
+
+bool HttpRequest(http_t http, PianoRequest_t * const request) {
+	int attempts = HTTP_RETRIES;
+
+	++http->stats.requests;
+
+	while (HttpTransferBegin (http, request, &attempts)) {
+		bool done = false;
+
+		while (HttpRequestReceive (http, request, &done) && !done)
+			;
+		if (done) {
+			HttpSetLastError (http, NULL);
+			return true;
+		}
+		if (http->transfer.status != HTTP_RETRY)
+			return false;
+		/* body did not make it, start over */
+		--attempts;
+	}
+
+	return false;
+}
+
+void HttpGetStats (http_t http, HttpStats_t* stats) {
+	*stats = http->stats;
+}
+
+const char* HttpGetError(http_t http) {
+	return http->error;
+}
@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piano_private.h"
+
+/* alignment of result objects */
+#define PIANO_ARENA_ALIGN (2*sizeof (void *))
+#define PIANO_ARENA_MINCHUNK 1024
+#define PIANO_ARENA_MAXCHUNK (64*1024)
+
+typedef struct PianoArenaChunk {
+	struct PianoArenaChunk *next;
+	unsigned char *data;
+	size_t size, used;
+} PianoArenaChunk_t;
+
+struct PianoArena {
+	/* one for the creator plus one per live object */
+	size_t refs;
+	/* current chunk first */
+	PianoArenaChunk_t *chunks;
+	/* first chunk’s data follows this struct */
+	PianoArenaChunk_t first;
+};
+
+/*	create arena, the caller holds one reference
+ *	@param expected size of all allocations, used for the first chunk
+ *	@return arena or NULL
+ */
+PianoArena_t *PianoArenaNew (size_t const hint) {
+	size_t size = hint;
+	if (size < PIANO_ARENA_MINCHUNK) {
+		size = PIANO_ARENA_MINCHUNK;
+	} else if (size > PIANO_ARENA_MAXCHUNK) {
+		size = PIANO_ARENA_MAXCHUNK;
+	}
+
+	PianoArena_t * const arena = malloc (sizeof (*arena) + size);
+	if (arena == NULL) {
+		return NULL;
+	}
+
+	arena->refs = 1;
+	arena->first.next = NULL;
+	arena->first.data = (unsigned char *) (arena+1);
+	arena->first.size = size;
+	arena->first.used = 0;
+	arena->chunks = &arena->first;
+
+	return arena;
+}
+
+/*	allocate size bytes aligned to align (power of two)
+ */
+static void *PianoArenaAllocAligned (PianoArena_t * const arena,
+		size_t const size, size_t const align) {
+	assert (arena != NULL);
+
+	PianoArenaChunk_t *chunk = arena->chunks;
+	uintptr_t start = ((uintptr_t) (chunk->data + chunk->used) + align-1) &
+			~(uintptr_t) (align-1);
+
+	if (start + size > (uintptr_t) (chunk->data + chunk->size)) {
+		/* grow geometrically, but never waste more than one chunk */
+		size_t chunkSize = chunk->size * 2;
+		if (chunkSize > PIANO_ARENA_MAXCHUNK) {
+			chunkSize = PIANO_ARENA_MAXCHUNK;
+		}
+		if (chunkSize < size + align) {
+			chunkSize = size + align;
+		}
+
+		PianoArenaChunk_t * const newChunk = malloc (sizeof (*newChunk) +
+				chunkSize);
+		if (newChunk == NULL) {
+			return NULL;
+		}
+		newChunk->data = (unsigned char *) (newChunk+1);
+		newChunk->size = chunkSize;
+		newChunk->used = 0;
+		newChunk->next = chunk;
+		arena->chunks = chunk = newChunk;
+		start = ((uintptr_t) chunk->data + align-1) & ~(uintptr_t) (align-1);
+	}
+
+	chunk->used = (start + size) - (uintptr_t) chunk->data;
+	return (void *) start;
+}
+
+/*	allocate unaligned memory, i.e. for strings
+ */
+void *PianoArenaAlloc (PianoArena_t * const arena, size_t const size) {
+	return PianoArenaAllocAligned (arena, size, 1);
+}
+
+/*	copy string into arena
+ */
+char *PianoArenaStrdup (PianoArena_t * const arena, const char * const s) {
+	const size_t len = strlen (s) + 1;
+	char * const ret = PianoArenaAlloc (arena, len);
+
+	if (ret != NULL) {
+		memcpy (ret, s, len);
+	}
+	return ret;
+}
+
+/*	allocate zeroed result object, which holds a reference to the arena
+ *	until it is destroyed
+ */
+void *PianoArenaObject (PianoArena_t * const arena, size_t const size) {
+	void * const ret = PianoArenaAllocAligned (arena, size, PIANO_ARENA_ALIGN);
+
+	if (ret != NULL) {
+		memset (ret, 0, size);
+		++arena->refs;
+	}
+	return ret;
+}
+
+/*	drop one reference, frees all memory once the last one is gone
+ *	@param arena, may be NULL
+ */
+void PianoArenaUnref (PianoArena_t * const arena) {
+	if (arena == NULL) {
+		return;
+	}
+
+	assert (arena->refs > 0);
+	if (--arena->refs > 0) {
+		return;
+	}
+
+	PianoArenaChunk_t *chunk = arena->chunks;
+	while (chunk != &arena->first) {
+		PianoArenaChunk_t * const next = chunk->next;
+		free (chunk);
+		chunk = next;
+	}
+	free (arena);
+}
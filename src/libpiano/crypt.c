@@ -31,19 +31,197 @@ THE SOFTWARE.
 
 #include <blowfish.h>
 
+#if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || \
+		defined (__i386__)
+#define PIANO_HEX_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+/* blocks processed per iteration of the ecb kernel; independent blocks hide
+ * the latency of the s-box lookups of each other */
+#define PIANO_CRYPT_LANES 4
+
+typedef enum {
+	/* kernel disagrees with library, use Blowfish_*Data */
+	PIANO_CRYPT_ORDER_LIBRARY = 0,
+	PIANO_CRYPT_ORDER_BIG_ENDIAN = 1,
+	PIANO_CRYPT_ORDER_LITTLE_ENDIAN = 2,
+} PianoCryptOrder_t;
+
 struct _PianoCipher_t {
 	BLOWFISH_CTX cipher;
+	/* copy of the key schedule for the interleaved kernel */
+	uint32_t p[18];
+	uint32_t s[4][256];
+	PianoCryptOrder_t order;
 };
 
+#define PIANO_CRYPT_F(s, x) ((((s)[0][(x) >> 24] + (s)[1][((x) >> 16) & 0xff]) ^ \
+		(s)[2][((x) >> 8) & 0xff]) + (s)[3][(x) & 0xff])
+
+/*	two feistel rounds on all lanes, left half uses key p[a], right half p[b]
+ */
+#define PIANO_CRYPT_ROUNDS(a, b) \
+	for (size_t k = 0; k < PIANO_CRYPT_LANES; k++) { \
+		l[k] ^= p[a]; \
+		r[k] ^= PIANO_CRYPT_F (s, l[k]); \
+	} \
+	for (size_t k = 0; k < PIANO_CRYPT_LANES; k++) { \
+		r[k] ^= p[b]; \
+		l[k] ^= PIANO_CRYPT_F (s, r[k]); \
+	}
+
+static inline uint32_t PianoCryptLoad (const unsigned char * const b,
+		const PianoCryptOrder_t order) {
+	if (order == PIANO_CRYPT_ORDER_BIG_ENDIAN) {
+		return (uint32_t) b[0] << 24 | (uint32_t) b[1] << 16 |
+				(uint32_t) b[2] << 8 | (uint32_t) b[3];
+	} else {
+		return (uint32_t) b[3] << 24 | (uint32_t) b[2] << 16 |
+				(uint32_t) b[1] << 8 | (uint32_t) b[0];
+	}
+}
+
+static inline void PianoCryptStore (unsigned char * const b, const uint32_t v,
+		const PianoCryptOrder_t order) {
+	if (order == PIANO_CRYPT_ORDER_BIG_ENDIAN) {
+		b[0] = (unsigned char) (v >> 24);
+		b[1] = (unsigned char) (v >> 16);
+		b[2] = (unsigned char) (v >> 8);
+		b[3] = (unsigned char) v;
+	} else {
+		b[3] = (unsigned char) (v >> 24);
+		b[2] = (unsigned char) (v >> 16);
+		b[1] = (unsigned char) (v >> 8);
+		b[0] = (unsigned char) v;
+	}
+}
+
+/*	en/decrypt PIANO_CRYPT_LANES consecutive 64 bit blocks in place
+ */
+static void PianoCryptLanes (const PianoCipher_t h, unsigned char * const data,
+		const PianoCryptOrder_t order, const bool encrypt) {
+	const uint32_t * const p = h->p;
+	const uint32_t (* const s)[256] = (const uint32_t (*)[256]) h->s;
+	uint32_t l[PIANO_CRYPT_LANES], r[PIANO_CRYPT_LANES];
+
+	for (size_t k = 0; k < PIANO_CRYPT_LANES; k++) {
+		l[k] = PianoCryptLoad (&data[k*8], order);
+		r[k] = PianoCryptLoad (&data[k*8+4], order);
+	}
+
+	if (encrypt) {
+		for (size_t i = 0; i < 16; i += 2) {
+			PIANO_CRYPT_ROUNDS (i, i+1);
+		}
+		for (size_t k = 0; k < PIANO_CRYPT_LANES; k++) {
+			l[k] ^= p[16];
+			r[k] ^= p[17];
+		}
+	} else {
+		for (size_t i = 17; i > 1; i -= 2) {
+			PIANO_CRYPT_ROUNDS (i, i-1);
+		}
+		for (size_t k = 0; k < PIANO_CRYPT_LANES; k++) {
+			l[k] ^= p[1];
+			r[k] ^= p[0];
+		}
+	}
+
+	/* halves are swapped on output */
+	for (size_t k = 0; k < PIANO_CRYPT_LANES; k++) {
+		PianoCryptStore (&data[k*8], r[k], order);
+		PianoCryptStore (&data[k*8+4], l[k], order);
+	}
+}
+
+#undef PIANO_CRYPT_ROUNDS
+#undef PIANO_CRYPT_F
+
+/*	ecb en/decrypt buffer in place, size must be a multiple of 8
+ */
+static bool PianoCryptEcb (const PianoCipher_t h, unsigned char * const data,
+		const size_t size, const PianoCryptOrder_t order, const bool encrypt) {
+	const size_t laneBytes = PIANO_CRYPT_LANES * 8;
+	size_t i = 0;
+
+	if (size % 8 != 0) {
+		return false;
+	}
+
+	for (; i + laneBytes <= size; i += laneBytes) {
+		PianoCryptLanes (h, &data[i], order, encrypt);
+	}
+
+	if (i < size) {
+		/* run the remaining blocks through a full set of lanes */
+		unsigned char tail[PIANO_CRYPT_LANES * 8];
+		memset (tail, 0, sizeof (tail));
+		memcpy (tail, &data[i], size - i);
+		PianoCryptLanes (h, tail, order, encrypt);
+		memcpy (&data[i], tail, size - i);
+	}
+
+	return true;
+}
+
+/*	find the block byte order Blowfish_*Data uses, so the kernel stays
+ *	bit-exact with it; falls back to the library if neither order matches
+ */
+static PianoCryptOrder_t PianoCryptDetectOrder (PianoCipher_t h) {
+	static const PianoCryptOrder_t orders[] = {PIANO_CRYPT_ORDER_BIG_ENDIAN,
+			PIANO_CRYPT_ORDER_LITTLE_ENDIAN};
+	/* five blocks, exercises full lanes and the remainder path */
+	uint32_t plain[10], reference[10];
+	unsigned char test[sizeof (plain)];
+
+	for (size_t i = 0; i < sizeof (plain); i++) {
+		((unsigned char *) plain)[i] = (unsigned char) (i * 37 + 11);
+	}
+	memcpy (reference, plain, sizeof (plain));
+	if (Blowfish_EncryptData (&h->cipher, reference, reference,
+			(int) sizeof (reference)) != BLOWFISH_OK) {
+		return PIANO_CRYPT_ORDER_LIBRARY;
+	}
+
+	for (size_t i = 0; i < sizeof (orders) / sizeof (*orders); i++) {
+		memcpy (test, plain, sizeof (test));
+		PianoCryptEcb (h, test, sizeof (test), orders[i], true);
+		if (memcmp (test, reference, sizeof (test)) != 0) {
+			continue;
+		}
+		PianoCryptEcb (h, test, sizeof (test), orders[i], false);
+		if (memcmp (test, plain, sizeof (test)) == 0) {
+			return orders[i];
+		}
+	}
+
+	return PIANO_CRYPT_ORDER_LIBRARY;
+}
+
 PianoReturn_t PianoCryptInit (PianoCipher_t* h, const char * const key,
 		size_t const size) {
-	PianoCipher_t result = malloc (sizeof(BLOWFISH_CTX));
+	PianoCipher_t result = malloc (sizeof(*result));
 	if (result == NULL) {
 		return PIANO_RET_OUT_OF_MEMORY;
 	}
 
 	Blowfish_Init (&result->cipher, (unsigned char*)key, (int)size);
 
+	for (size_t i = 0; i < 18; i++) {
+		result->p[i] = (uint32_t) result->cipher.P[i];
+	}
+	for (size_t i = 0; i < 4; i++) {
+		for (size_t j = 0; j < 256; j++) {
+			result->s[i][j] = (uint32_t) result->cipher.S[i][j];
+		}
+	}
+	result->order = PianoCryptDetectOrder (result);
+
 	*h = result;
 
 	return PIANO_RET_OK;
@@ -54,14 +232,370 @@ void PianoCryptDestroy (PianoCipher_t h) {
 }
 
 static inline bool PianoCryptDecrypt (PianoCipher_t h, unsigned char* output, size_t size) {
+	if (h->order != PIANO_CRYPT_ORDER_LIBRARY) {
+		return PianoCryptEcb (h, output, size, h->order, false);
+	}
 	return Blowfish_DecryptData (&h->cipher, (uint32_t*)output, (uint32_t*)output, (int)size) == BLOWFISH_OK;
 }
 
 static inline bool PianoCryptEncrypt (PianoCipher_t h, unsigned char* output, size_t size)
 {
+	if (h->order != PIANO_CRYPT_ORDER_LIBRARY) {
+		return PianoCryptEcb (h, output, size, h->order, true);
+	}
 	return Blowfish_EncryptData (&h->cipher, (uint32_t*)output, (uint32_t*)output, (int)size) == BLOWFISH_OK;
 }
 
+/*	ecb en/decrypt buffer in place with either the interleaved kernel or
+ *	Blowfish_*Data, for checks and benchmarks
+ *	@param cipher handle
+ *	@param buffer
+ *	@param buffer size, multiple of 8
+ *	@param encrypt or decrypt
+ *	@param use kernel
+ *	@return false on error, or if the kernel is requested but disabled
+ *		because it disagreed with the library
+ */
+bool PianoCryptData (PianoCipher_t h, unsigned char * const data,
+		size_t const size, bool const encrypt, bool const interleaved) {
+	if (interleaved) {
+		return h->order != PIANO_CRYPT_ORDER_LIBRARY &&
+				PianoCryptEcb (h, data, size, h->order, encrypt);
+	}
+	if (encrypt) {
+		return Blowfish_EncryptData (&h->cipher, (uint32_t *) data,
+				(uint32_t *) data, (int) size) == BLOWFISH_OK;
+	}
+	return Blowfish_DecryptData (&h->cipher, (uint32_t *) data,
+			(uint32_t *) data, (int) size) == BLOWFISH_OK;
+}
+
+/*	hex codec: lookup tables for the scalar path, SSE2/AVX2 kernels for long
+ *	inputs. kernels are picked once at runtime based on cpu features.
+ */
+static const char PianoHexEncodeTable[513] =
+		"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+		"202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f"
+		"404142434445464748494a4b4c4d4e4f505152535455565758595a5b5c5d5e5f"
+		"606162636465666768696a6b6c6d6e6f707172737475767778797a7b7c7d7e7f"
+		"808182838485868788898a8b8c8d8e8f909192939495969798999a9b9c9d9e9f"
+		"a0a1a2a3a4a5a6a7a8a9aaabacadaeafb0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+		"c0c1c2c3c4c5c6c7c8c9cacbcccdcecfd0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+		"e0e1e2e3e4e5e6e7e8e9eaebecedeeeff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+static const signed char PianoHexDecodeTable[256] = {
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		};
+
+typedef void (*PianoHexEncodeFunc_t) (const unsigned char *, size_t, char *);
+typedef bool (*PianoHexDecodeFunc_t) (const char *, size_t, unsigned char *);
+
+static void PianoHexEncodeScalar (const unsigned char *input, size_t size,
+		char *output) {
+	for (size_t i = 0; i < size; i++) {
+		memcpy (&output[i*2], &PianoHexEncodeTable[input[i]*2], 2);
+	}
+}
+
+static bool PianoHexDecodeScalar (const char *input, size_t size,
+		unsigned char *output) {
+	for (size_t i = 0; i < size; i++) {
+		const int hi = PianoHexDecodeTable[(unsigned char) input[i*2]];
+		const int lo = PianoHexDecodeTable[(unsigned char) input[i*2+1]];
+		if ((hi | lo) < 0) {
+			return false;
+		}
+		output[i] = (unsigned char) ((hi << 4) | lo);
+	}
+	return true;
+}
+
+#ifdef PIANO_HEX_X86
+/*	convert 16 nibbles to lowercase ascii: '0'+n, plus 'a'-'0'-10 for n > 9
+ */
+__attribute__ ((target ("sse2")))
+static inline __m128i PianoHexNibbleSse2 (__m128i n) {
+	const __m128i letter = _mm_and_si128 (_mm_cmpgt_epi8 (n,
+			_mm_set1_epi8 (9)), _mm_set1_epi8 ('a'-'0'-10));
+	return _mm_add_epi8 (_mm_add_epi8 (n, _mm_set1_epi8 ('0')), letter);
+}
+
+/*	convert 16 ascii hex digits to nibbles, sets *valid to false if any of
+ *	them is not a hex digit
+ */
+__attribute__ ((target ("sse2")))
+static inline __m128i PianoHexDigitSse2 (__m128i c, bool *valid) {
+	const __m128i d = _mm_sub_epi8 (c, _mm_set1_epi8 ('0'));
+	const __m128i isDigit = _mm_and_si128 (
+			_mm_cmpgt_epi8 (d, _mm_set1_epi8 (-1)),
+			_mm_cmplt_epi8 (d, _mm_set1_epi8 (10)));
+	/* fold to lowercase, letters map to 0..5 */
+	const __m128i l = _mm_sub_epi8 (_mm_or_si128 (c, _mm_set1_epi8 (0x20)),
+			_mm_set1_epi8 ('a'));
+	const __m128i isAlpha = _mm_and_si128 (
+			_mm_cmpgt_epi8 (l, _mm_set1_epi8 (-1)),
+			_mm_cmplt_epi8 (l, _mm_set1_epi8 (6)));
+	if (_mm_movemask_epi8 (_mm_or_si128 (isDigit, isAlpha)) != 0xffff) {
+		*valid = false;
+	}
+	return _mm_or_si128 (_mm_and_si128 (d, isDigit), _mm_and_si128 (
+			_mm_add_epi8 (l, _mm_set1_epi8 (10)), isAlpha));
+}
+
+__attribute__ ((target ("sse2")))
+static void PianoHexEncodeSse2 (const unsigned char *input, size_t size,
+		char *output) {
+	const __m128i mask = _mm_set1_epi8 (0x0f);
+	size_t i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		const __m128i v = _mm_loadu_si128 ((const __m128i *) &input[i]);
+		const __m128i hi = PianoHexNibbleSse2 (_mm_and_si128 (
+				_mm_srli_epi16 (v, 4), mask));
+		const __m128i lo = PianoHexNibbleSse2 (_mm_and_si128 (v, mask));
+		_mm_storeu_si128 ((__m128i *) &output[i*2],
+				_mm_unpacklo_epi8 (hi, lo));
+		_mm_storeu_si128 ((__m128i *) &output[i*2+16],
+				_mm_unpackhi_epi8 (hi, lo));
+	}
+
+	PianoHexEncodeScalar (&input[i], size - i, &output[i*2]);
+}
+
+__attribute__ ((target ("sse2")))
+static bool PianoHexDecodeSse2 (const char *input, size_t size,
+		unsigned char *output) {
+	const __m128i lowByte = _mm_set1_epi16 (0x00ff);
+	bool valid = true;
+	size_t i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		/* each 16 bit lane holds high nibble in its low byte and vice versa */
+		const __m128i a = PianoHexDigitSse2 (_mm_loadu_si128 (
+				(const __m128i *) &input[i*2]), &valid);
+		const __m128i b = PianoHexDigitSse2 (_mm_loadu_si128 (
+				(const __m128i *) &input[i*2+16]), &valid);
+		const __m128i wa = _mm_or_si128 (_mm_slli_epi16 (
+				_mm_and_si128 (a, lowByte), 4), _mm_srli_epi16 (a, 8));
+		const __m128i wb = _mm_or_si128 (_mm_slli_epi16 (
+				_mm_and_si128 (b, lowByte), 4), _mm_srli_epi16 (b, 8));
+		_mm_storeu_si128 ((__m128i *) &output[i], _mm_packus_epi16 (wa, wb));
+	}
+
+	return valid && PianoHexDecodeScalar (&input[i*2], size - i, &output[i]);
+}
+
+__attribute__ ((target ("avx2")))
+static inline __m256i PianoHexNibbleAvx2 (__m256i n) {
+	const __m256i letter = _mm256_and_si256 (_mm256_cmpgt_epi8 (n,
+			_mm256_set1_epi8 (9)), _mm256_set1_epi8 ('a'-'0'-10));
+	return _mm256_add_epi8 (_mm256_add_epi8 (n, _mm256_set1_epi8 ('0')),
+			letter);
+}
+
+__attribute__ ((target ("avx2")))
+static inline __m256i PianoHexDigitAvx2 (__m256i c, bool *valid) {
+	const __m256i d = _mm256_sub_epi8 (c, _mm256_set1_epi8 ('0'));
+	const __m256i isDigit = _mm256_and_si256 (
+			_mm256_cmpgt_epi8 (d, _mm256_set1_epi8 (-1)),
+			_mm256_cmpgt_epi8 (_mm256_set1_epi8 (10), d));
+	const __m256i l = _mm256_sub_epi8 (_mm256_or_si256 (c,
+			_mm256_set1_epi8 (0x20)), _mm256_set1_epi8 ('a'));
+	const __m256i isAlpha = _mm256_and_si256 (
+			_mm256_cmpgt_epi8 (l, _mm256_set1_epi8 (-1)),
+			_mm256_cmpgt_epi8 (_mm256_set1_epi8 (6), l));
+	if (_mm256_movemask_epi8 (_mm256_or_si256 (isDigit, isAlpha)) != -1) {
+		*valid = false;
+	}
+	return _mm256_or_si256 (_mm256_and_si256 (d, isDigit), _mm256_and_si256 (
+			_mm256_add_epi8 (l, _mm256_set1_epi8 (10)), isAlpha));
+}
+
+__attribute__ ((target ("avx2")))
+static void PianoHexEncodeAvx2 (const unsigned char *input, size_t size,
+		char *output) {
+	const __m256i mask = _mm256_set1_epi8 (0x0f);
+	size_t i = 0;
+
+	for (; i + 32 <= size; i += 32) {
+		const __m256i v = _mm256_loadu_si256 ((const __m256i *) &input[i]);
+		const __m256i hi = PianoHexNibbleAvx2 (_mm256_and_si256 (
+				_mm256_srli_epi16 (v, 4), mask));
+		const __m256i lo = PianoHexNibbleAvx2 (_mm256_and_si256 (v, mask));
+		/* unpack works per 128 bit lane, put the halves back in order */
+		const __m256i first = _mm256_unpacklo_epi8 (hi, lo);
+		const __m256i second = _mm256_unpackhi_epi8 (hi, lo);
+		_mm256_storeu_si256 ((__m256i *) &output[i*2],
+				_mm256_permute2x128_si256 (first, second, 0x20));
+		_mm256_storeu_si256 ((__m256i *) &output[i*2+32],
+				_mm256_permute2x128_si256 (first, second, 0x31));
+	}
+
+	PianoHexEncodeSse2 (&input[i], size - i, &output[i*2]);
+}
+
+__attribute__ ((target ("avx2")))
+static bool PianoHexDecodeAvx2 (const char *input, size_t size,
+		unsigned char *output) {
+	const __m256i lowByte = _mm256_set1_epi16 (0x00ff);
+	bool valid = true;
+	size_t i = 0;
+
+	for (; i + 32 <= size; i += 32) {
+		const __m256i a = PianoHexDigitAvx2 (_mm256_loadu_si256 (
+				(const __m256i *) &input[i*2]), &valid);
+		const __m256i b = PianoHexDigitAvx2 (_mm256_loadu_si256 (
+				(const __m256i *) &input[i*2+32]), &valid);
+		const __m256i wa = _mm256_or_si256 (_mm256_slli_epi16 (
+				_mm256_and_si256 (a, lowByte), 4), _mm256_srli_epi16 (a, 8));
+		const __m256i wb = _mm256_or_si256 (_mm256_slli_epi16 (
+				_mm256_and_si256 (b, lowByte), 4), _mm256_srli_epi16 (b, 8));
+		/* packus interleaves 128 bit lanes as well */
+		_mm256_storeu_si256 ((__m256i *) &output[i], _mm256_permute4x64_epi64 (
+				_mm256_packus_epi16 (wa, wb), 0xd8));
+	}
+
+	return valid && PianoHexDecodeSse2 (&input[i*2], size - i, &output[i]);
+}
+
+/*	check cpu (and os, for avx) support for vector kernels
+ */
+static void PianoHexCpuFeatures (bool *sse2, bool *avx2) {
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid (info, 0);
+	const int maxLeaf = info[0];
+	__cpuid (info, 1);
+	*sse2 = (info[3] & (1 << 26)) != 0;
+	*avx2 = false;
+	/* osxsave and avx, ymm state enabled by the os */
+	if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+			(_xgetbv (0) & 0x6) == 0x6 && maxLeaf >= 7) {
+		__cpuidex (info, 7, 0);
+		*avx2 = (info[1] & (1 << 5)) != 0;
+	}
+#else
+	__builtin_cpu_init ();
+	*sse2 = __builtin_cpu_supports ("sse2");
+	*avx2 = __builtin_cpu_supports ("avx2");
+#endif
+}
+#endif
+
+static void PianoHexEncodeSelect (const unsigned char *, size_t, char *);
+static bool PianoHexDecodeSelect (const char *, size_t, unsigned char *);
+
+static PianoHexEncodeFunc_t PianoHexEncodeImpl = PianoHexEncodeSelect;
+static PianoHexDecodeFunc_t PianoHexDecodeImpl = PianoHexDecodeSelect;
+
+/*	pick kernels on first use; racing threads store the same values
+ */
+static void PianoHexSelect (void) {
+	PianoHexEncodeFunc_t encode = PianoHexEncodeScalar;
+	PianoHexDecodeFunc_t decode = PianoHexDecodeScalar;
+
+#ifdef PIANO_HEX_X86
+	bool sse2, avx2;
+	PianoHexCpuFeatures (&sse2, &avx2);
+	if (avx2) {
+		encode = PianoHexEncodeAvx2;
+		decode = PianoHexDecodeAvx2;
+	} else if (sse2) {
+		encode = PianoHexEncodeSse2;
+		decode = PianoHexDecodeSse2;
+	}
+#endif
+
+	PianoHexEncodeImpl = encode;
+	PianoHexDecodeImpl = decode;
+}
+
+static void PianoHexEncodeSelect (const unsigned char *input, size_t size,
+		char *output) {
+	PianoHexSelect ();
+	PianoHexEncodeImpl (input, size, output);
+}
+
+static bool PianoHexDecodeSelect (const char *input, size_t size,
+		unsigned char *output) {
+	PianoHexSelect ();
+	return PianoHexDecodeImpl (input, size, output);
+}
+
+/*	use kernel instead of the one picked by cpu features, for checks and
+ *	benchmarks; not thread-safe
+ *	@return false if the cpu does not support it
+ */
+bool PianoHexUseKernel (const PianoHexKernel_t kernel) {
+	PianoHexEncodeFunc_t encode = PianoHexEncodeScalar;
+	PianoHexDecodeFunc_t decode = PianoHexDecodeScalar;
+
+	if (kernel != PIANO_HEX_KERNEL_SCALAR) {
+#ifdef PIANO_HEX_X86
+		bool sse2, avx2;
+		PianoHexCpuFeatures (&sse2, &avx2);
+		if (kernel == PIANO_HEX_KERNEL_SSE2 && sse2) {
+			encode = PianoHexEncodeSse2;
+			decode = PianoHexDecodeSse2;
+		} else if (kernel == PIANO_HEX_KERNEL_AVX2 && avx2) {
+			encode = PianoHexEncodeAvx2;
+			decode = PianoHexDecodeAvx2;
+		} else {
+			return false;
+		}
+#else
+		return false;
+#endif
+	}
+
+	PianoHexEncodeImpl = encode;
+	PianoHexDecodeImpl = decode;
+	return true;
+}
+
+/*	hex-encode binary data (lowercase), output is _not_ NUL-terminated
+ *	@param input data
+ *	@param input size in bytes
+ *	@param output buffer, at least 2*size bytes
+ */
+void PianoHexEncode (const unsigned char * const input, size_t const size,
+		char * const output) {
+	assert (input != NULL || size == 0);
+	assert (output != NULL || size == 0);
+
+	PianoHexEncodeImpl (input, size, output);
+}
+
+/*	decode hex string (either case)
+ *	@param input string, 2*size characters
+ *	@param output size in bytes
+ *	@param output buffer, at least size bytes
+ *	@return false if input contains non-hex characters
+ */
+bool PianoHexDecode (const char * const input, size_t const size,
+		unsigned char * const output) {
+	assert (input != NULL || size == 0);
+	assert (output != NULL || size == 0);
+
+	return PianoHexDecodeImpl (input, size, output);
+}
+
 /*	decrypt hex-encoded, blowfish-crypted string: decode 2 hex-encoded blocks,
  *	decrypt, byteswap
  *	@param cipher handle
@@ -79,12 +613,12 @@ char *PianoDecryptString (PianoCipher_t h, const char * const input,
 	assert (inputLen%2 == 0);
 
 	output = calloc (outputLen+1, sizeof (*output));
-	/* hex decode */
-	for (size_t i = 0; i < outputLen; i++) {
-		char hex[3];
-		memcpy (hex, &input[i*2], 2);
-		hex[2] = '\0';
-		output[i] = (unsigned char) strtol (hex, NULL, 16);
+	if (output == NULL) {
+		return NULL;
+	}
+	if (!PianoHexDecode (input, outputLen, output)) {
+		free (output);
+		return NULL;
 	}
 
 	ret = PianoCryptDecrypt (h, output, outputLen);
@@ -98,34 +632,69 @@ char *PianoDecryptString (PianoCipher_t h, const char * const input,
 	return (char *) output;
 }
 
+/*	size of the buffer PianoEncryptInPlace needs for input of given size
+ *	@param plaintext size in bytes, without trailing NUL
+ *	@return buffer size, including trailing NUL
+ */
+size_t PianoEncryptedSize (size_t const inputLen) {
+	/* blowfish expects two 32 bit blocks */
+	const size_t paddedInputLen = (inputLen % 8 == 0) ? inputLen :
+			inputLen + (8-inputLen%8);
+	return paddedInputLen*2+1;
+}
+
+/*	blowfish-encrypt/hex-encode buffer in place: plaintext is zero-padded,
+ *	encrypted and expanded to hex back to front, so no copy is needed
+ *	@param cipher handle
+ *	@param buffer, PianoEncryptedSize (inputLen) bytes, plaintext at start
+ *	@param plaintext size
+ *	@return false on error, buffer contents are undefined then
+ */
+bool PianoEncryptInPlace (PianoCipher_t h, char * const buf,
+		size_t const inputLen) {
+	unsigned char * const data = (unsigned char *) buf;
+	const size_t paddedInputLen = (PianoEncryptedSize (inputLen)-1)/2;
+	/* expanded through a small bounce buffer, so any hex kernel works */
+	unsigned char chunk[256];
+
+	memset (&data[inputLen], 0, paddedInputLen - inputLen);
+
+	if (!PianoCryptEncrypt (h, data, paddedInputLen)) {
+		return false;
+	}
+
+	/* each byte becomes two characters at twice its offset; going backwards
+	 * never overwrites bytes not yet expanded */
+	size_t end = paddedInputLen;
+	while (end > 0) {
+		const size_t start = end > sizeof (chunk) ? end - sizeof (chunk) : 0;
+		memcpy (chunk, &data[start], end - start);
+		PianoHexEncode (chunk, end - start, &buf[start*2]);
+		end = start;
+	}
+	buf[paddedInputLen*2] = '\0';
+
+	return true;
+}
+
 /*	blowfish-encrypt/hex-encode string
  *	@param cipher handle
  *	@param encrypt this
  *	@return encrypted, hex-encoded string
  */
 char *PianoEncryptString (PianoCipher_t h, const char *s) {
-	unsigned char *paddedInput, *hexOutput;
-	size_t inputLen = strlen (s);
-	/* blowfish expects two 32 bit blocks */
-	size_t paddedInputLen = (inputLen % 8 == 0) ? inputLen : inputLen + (8-inputLen%8);
-	bool ret;
+	const size_t inputLen = strlen (s);
+	char * const output = malloc (PianoEncryptedSize (inputLen));
 
-	paddedInput = calloc (paddedInputLen+1, sizeof (*paddedInput));
-	memcpy (paddedInput, s, inputLen);
-
-	ret = PianoCryptEncrypt (h, paddedInput, paddedInputLen);
-	if (!ret) {
-		free (paddedInput);
+	if (output == NULL) {
 		return NULL;
 	}
 
-	hexOutput = calloc (paddedInputLen*2+1, sizeof (*hexOutput));
-	for (size_t i = 0; i < paddedInputLen; i++) {
-		snprintf ((char * restrict) &hexOutput[i*2], 3, "%02x", paddedInput[i]);
+	memcpy (output, s, inputLen);
+	if (!PianoEncryptInPlace (h, output, inputLen)) {
+		free (output);
+		return NULL;
 	}
 
-	free (paddedInput);
-
-	return (char *) hexOutput;
+	return output;
 }
-
@@ -25,11 +25,25 @@ THE SOFTWARE.
 
 #include "piano.h"
 
+typedef enum {
+	PIANO_HEX_KERNEL_SCALAR = 0,
+	PIANO_HEX_KERNEL_SSE2,
+	PIANO_HEX_KERNEL_AVX2,
+} PianoHexKernel_t;
+
 PianoReturn_t PianoCryptInit (PianoCipher_t*, const char * const,
 		size_t const);
 void PianoCryptDestroy (PianoCipher_t);
+bool PianoCryptData (PianoCipher_t, unsigned char * const, size_t const,
+		bool const, bool const);
 
 char *PianoDecryptString (PianoCipher_t, const char * const,
 		size_t * const);
 char *PianoEncryptString (PianoCipher_t, const char *);
+size_t PianoEncryptedSize (size_t const);
+bool PianoEncryptInPlace (PianoCipher_t, char * const, size_t const);
+
+void PianoHexEncode (const unsigned char * const, size_t const, char * const);
+bool PianoHexDecode (const char * const, size_t const, unsigned char * const);
+bool PianoHexUseKernel (const PianoHexKernel_t);
 
@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piano_private.h"
+
+#define PIANO_INTERN_MINSIZE 64
+
+typedef struct PianoInternEntry {
+	struct PianoInternEntry *next;
+	size_t refs;
+	uint32_t hash;
+	char str[];
+} PianoInternEntry_t;
+
+/* song metadata repeats a lot (same artist, album and station over and
+ * over), so those strings are shared by every song referencing them. The
+ * table is process-wide, because results are destroyed without a handle;
+ * like the rest of libpiano it must only be used from one thread. */
+static struct {
+	PianoInternEntry_t **buckets;
+	/* number of buckets, power of two */
+	size_t size;
+	size_t count;
+} table;
+
+/*	FNV-1a
+ */
+static uint32_t PianoInternHash (const char * const s, const size_t len) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		h ^= (unsigned char) s[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+/*	double the number of buckets
+ *	@return false if out of memory, the table is unchanged then
+ */
+static bool PianoInternGrow (void) {
+	const size_t newSize = table.size == 0 ? PIANO_INTERN_MINSIZE :
+			table.size*2;
+	PianoInternEntry_t ** const buckets = calloc (newSize, sizeof (*buckets));
+	if (buckets == NULL) {
+		return false;
+	}
+
+	for (size_t i = 0; i < table.size; i++) {
+		PianoInternEntry_t *e = table.buckets[i];
+		while (e != NULL) {
+			PianoInternEntry_t * const next = e->next;
+			PianoInternEntry_t ** const b = &buckets[e->hash & (newSize-1)];
+			e->next = *b;
+			*b = e;
+			e = next;
+		}
+	}
+	free (table.buckets);
+	table.buckets = buckets;
+	table.size = newSize;
+
+	return true;
+}
+
+/*	get shared copy of string s, release it with PianoStrRelease
+ *	@param string, may be NULL
+ *	@return shared copy, NULL if s is NULL or out of memory
+ */
+char *PianoStrIntern (const char * const s) {
+	if (s == NULL) {
+		return NULL;
+	}
+
+	const size_t len = strlen (s);
+	const uint32_t hash = PianoInternHash (s, len);
+
+	if (table.size != 0) {
+		PianoInternEntry_t *e = table.buckets[hash & (table.size-1)];
+		for (; e != NULL; e = e->next) {
+			if (e->hash == hash && strcmp (e->str, s) == 0) {
+				++e->refs;
+				return e->str;
+			}
+		}
+	}
+
+	/* keep chains short; a failed resize just makes them longer */
+	if (table.count >= table.size && !PianoInternGrow () && table.size == 0) {
+		return NULL;
+	}
+
+	PianoInternEntry_t * const e = malloc (sizeof (*e) + len + 1);
+	if (e == NULL) {
+		return NULL;
+	}
+	e->refs = 1;
+	e->hash = hash;
+	memcpy (e->str, s, len + 1);
+
+	PianoInternEntry_t ** const b = &table.buckets[hash & (table.size-1)];
+	e->next = *b;
+	*b = e;
+	++table.count;
+
+	return e->str;
+}
+
+/*	drop reference to string returned by PianoStrIntern
+ *	@param string, may be NULL
+ */
+void PianoStrRelease (char * const s) {
+	if (s == NULL) {
+		return;
+	}
+
+	PianoInternEntry_t * const e = (PianoInternEntry_t *) (s -
+			offsetof (PianoInternEntry_t, str));
+	assert (e->refs > 0);
+	if (--e->refs > 0) {
+		return;
+	}
+
+	PianoInternEntry_t **prev = &table.buckets[e->hash & (table.size-1)];
+	while (*prev != e) {
+		assert (*prev != NULL);
+		prev = &(*prev)->next;
+	}
+	*prev = e->next;
+	free (e);
+
+	if (--table.count == 0) {
+		/* nothing left, do not leak the table */
+		free (table.buckets);
+		table.buckets = NULL;
+		table.size = 0;
+	}
+}
@@ -0,0 +1,704 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsonpull.h"
+
+/* pandora does not nest deeper than five levels, json-c gives up at 32 */
+#define PIANO_JSON_MAXDEPTH 16
+
+static bool PianoJsonFail (PianoJsonReader_t * const r) {
+	r->error = true;
+	return false;
+}
+
+/*	fetch more text, keeping the position
+ *	@return false if there is none
+ */
+static bool PianoJsonMore (PianoJsonReader_t * const r) {
+	const char *text;
+
+	if (r->more == NULL || !r->more (r->moreData, &text)) {
+		return false;
+	}
+	r->pos = text + (r->pos - r->text);
+	r->text = text;
+	return true;
+}
+
+/*	make sure the token at the current position, made of chars, is not cut
+ *	off by the end of text
+ */
+static void PianoJsonToken (PianoJsonReader_t * const r,
+		const char * const chars) {
+	while (r->pos[strspn (r->pos, chars)] == '\0' && PianoJsonMore (r)) {
+	}
+}
+
+static void PianoJsonSpace (PianoJsonReader_t * const r) {
+	do {
+		while (*r->pos == ' ' || *r->pos == '\t' || *r->pos == '\n' ||
+				*r->pos == '\r') {
+			++r->pos;
+		}
+	} while (*r->pos == '\0' && PianoJsonMore (r));
+}
+
+static int PianoJsonHex (const char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+/*	read four hex digits of an \u escape
+ *	@return code unit or -1
+ */
+static long PianoJsonCodeUnit (const char * const s) {
+	long unit = 0;
+
+	for (size_t i = 0; i < 4; i++) {
+		const int digit = PianoJsonHex (s[i]);
+		if (digit < 0) {
+			return -1;
+		}
+		unit = (unit << 4) | digit;
+	}
+	return unit;
+}
+
+/*	find the closing quote of the string starting at s (after the opening
+ *	quote)
+ *	@return pointer to closing quote, or to the control character (including
+ *		the terminating NUL) ending the string early
+ */
+static const char *PianoJsonStringEnd (const char *s) {
+	while (*s != '"') {
+		if ((unsigned char) *s < 0x20) {
+			return s;
+		} else if (*s == '\\') {
+			++s;
+			if (*s == '\0') {
+				return s;
+			}
+		}
+		++s;
+	}
+	return s;
+}
+
+/*	find the end of the string at the current position, fetching more text
+ *	if it is cut off
+ *	@return pointer to closing quote or NULL if string is not terminated
+ */
+static const char *PianoJsonStringComplete (PianoJsonReader_t * const r) {
+	const char *end;
+
+	assert (*r->pos == '"');
+	while (*(end = PianoJsonStringEnd (r->pos+1)) == '\0' &&
+			PianoJsonMore (r)) {
+	}
+	return *end == '"' ? end : NULL;
+}
+
+/*	unescape string [src, end) into dest, which must be at least end-src+1
+ *	bytes long. dest may be NULL to validate only.
+ *	@param decoded length (without NUL) is stored here
+ *	@return false on invalid escape sequence
+ */
+static bool PianoJsonUnescape (const char *src, const char * const end,
+		char *dest, size_t * const retLen) {
+	size_t len = 0;
+
+	while (src < end) {
+		const char * const next = memchr (src, '\\', end - src);
+		const size_t plain = (next == NULL ? end : next) - src;
+
+		if (dest != NULL) {
+			memcpy (&dest[len], src, plain);
+		}
+		len += plain;
+		src += plain;
+		if (src == end) {
+			break;
+		}
+
+		/* escape sequence */
+		++src;
+		char c;
+		switch (*src) {
+			case '"':
+			case '\\':
+			case '/':
+				c = *src;
+				break;
+
+			case 'b':
+				c = '\b';
+				break;
+
+			case 'f':
+				c = '\f';
+				break;
+
+			case 'n':
+				c = '\n';
+				break;
+
+			case 'r':
+				c = '\r';
+				break;
+
+			case 't':
+				c = '\t';
+				break;
+
+			case 'u': {
+				if (end - src < 5) {
+					return false;
+				}
+				long cp = PianoJsonCodeUnit (src+1);
+				src += 5;
+				if (cp < 0 || (cp >= 0xdc00 && cp <= 0xdfff)) {
+					return false;
+				} else if (cp >= 0xd800 && cp <= 0xdbff) {
+					/* surrogate pair */
+					if (end - src < 6 || src[0] != '\\' || src[1] != 'u') {
+						return false;
+					}
+					const long low = PianoJsonCodeUnit (src+2);
+					if (low < 0xdc00 || low > 0xdfff) {
+						return false;
+					}
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+					src += 6;
+				}
+
+				/* utf-8 encode */
+				unsigned char utf8[4];
+				size_t n;
+				if (cp < 0x80) {
+					utf8[0] = cp;
+					n = 1;
+				} else if (cp < 0x800) {
+					utf8[0] = 0xc0 | (cp >> 6);
+					utf8[1] = 0x80 | (cp & 0x3f);
+					n = 2;
+				} else if (cp < 0x10000) {
+					utf8[0] = 0xe0 | (cp >> 12);
+					utf8[1] = 0x80 | ((cp >> 6) & 0x3f);
+					utf8[2] = 0x80 | (cp & 0x3f);
+					n = 3;
+				} else {
+					utf8[0] = 0xf0 | (cp >> 18);
+					utf8[1] = 0x80 | ((cp >> 12) & 0x3f);
+					utf8[2] = 0x80 | ((cp >> 6) & 0x3f);
+					utf8[3] = 0x80 | (cp & 0x3f);
+					n = 4;
+				}
+				if (dest != NULL) {
+					memcpy (&dest[len], utf8, n);
+				}
+				len += n;
+				continue;
+			}
+
+			default:
+				return false;
+		}
+		if (dest != NULL) {
+			dest[len] = c;
+		}
+		++len;
+		++src;
+	}
+
+	if (dest != NULL) {
+		dest[len] = '\0';
+	}
+	*retLen = len;
+	return true;
+}
+
+/*	read string at current position
+ *	@param store copy here, may be NULL to skip the string
+ *	@param decoded length
+ *	@param allocate copy with r->alloc instead of malloc
+ */
+static bool PianoJsonString (PianoJsonReader_t * const r, char ** const ret,
+		size_t * const len, const bool useAlloc) {
+	const char * const end = PianoJsonStringComplete (r);
+	if (end == NULL) {
+		return PianoJsonFail (r);
+	}
+	const char * const start = r->pos+1;
+
+	const bool custom = useAlloc && r->alloc != NULL;
+	char *dest = NULL;
+	if (ret != NULL) {
+		dest = custom ? r->alloc (r->allocData, end - start + 1) :
+				malloc (end - start + 1);
+		if (dest == NULL) {
+			return PianoJsonFail (r);
+		}
+	}
+	if (!PianoJsonUnescape (start, end, dest, len)) {
+		if (!custom) {
+			free (dest);
+		}
+		return PianoJsonFail (r);
+	}
+	if (ret != NULL) {
+		*ret = dest;
+	}
+	r->pos = end+1;
+	return true;
+}
+
+/*	skip over number at current position
+ *	@param set to true if the number has a fraction or exponent
+ *	@return start of number or NULL
+ */
+static const char *PianoJsonNumber (PianoJsonReader_t * const r,
+		bool * const isDouble) {
+	PianoJsonToken (r, "0123456789+-.eE");
+
+	const char * const start = r->pos;
+	const char *p = start;
+
+	*isDouble = false;
+	if (*p == '-') {
+		++p;
+	}
+	if (*p == '0') {
+		++p;
+	} else if (*p >= '1' && *p <= '9') {
+		while (*p >= '0' && *p <= '9') {
+			++p;
+		}
+	} else {
+		PianoJsonFail (r);
+		return NULL;
+	}
+	if (*p == '.') {
+		++p;
+		*isDouble = true;
+		if (!(*p >= '0' && *p <= '9')) {
+			PianoJsonFail (r);
+			return NULL;
+		}
+		while (*p >= '0' && *p <= '9') {
+			++p;
+		}
+	}
+	if (*p == 'e' || *p == 'E') {
+		++p;
+		*isDouble = true;
+		if (*p == '+' || *p == '-') {
+			++p;
+		}
+		if (!(*p >= '0' && *p <= '9')) {
+			PianoJsonFail (r);
+			return NULL;
+		}
+		while (*p >= '0' && *p <= '9') {
+			++p;
+		}
+	}
+	r->pos = p;
+	return start;
+}
+
+/*	consume literal lit at current position
+ */
+static bool PianoJsonLiteral (PianoJsonReader_t * const r,
+		const char * const lit) {
+	const size_t len = strlen (lit);
+
+	PianoJsonToken (r, "abcdefghijklmnopqrstuvwxyz");
+	if (strncmp (r->pos, lit, len) != 0) {
+		return PianoJsonFail (r);
+	}
+	r->pos += len;
+	return true;
+}
+
+/*	start reading NUL-terminated json text, set more afterwards if it is
+ *	incomplete
+ */
+void PianoJsonInit (PianoJsonReader_t * const r, const char * const text) {
+	assert (r != NULL);
+
+	memset (r, 0, sizeof (*r));
+	if (text == NULL) {
+		r->pos = "";
+		r->error = true;
+	} else {
+		r->pos = text;
+	}
+	r->text = r->pos;
+}
+
+/*	get type of next value without consuming it
+ */
+PianoJsonType_t PianoJsonPeek (PianoJsonReader_t * const r) {
+	if (r->error) {
+		return PIANO_JSON_INVALID;
+	}
+
+	PianoJsonSpace (r);
+	switch (*r->pos) {
+		case '{':
+			return PIANO_JSON_OBJECT;
+
+		case '[':
+			return PIANO_JSON_ARRAY;
+
+		case '"':
+			return PIANO_JSON_STRING;
+
+		case 't':
+		case 'f':
+			return PIANO_JSON_BOOLEAN;
+
+		case 'n':
+			return PIANO_JSON_NULL;
+
+		default:
+			if (*r->pos == '-' || (*r->pos >= '0' && *r->pos <= '9')) {
+				return PIANO_JSON_NUMBER;
+			}
+			return PIANO_JSON_INVALID;
+	}
+}
+
+static bool PianoJsonBegin (PianoJsonReader_t * const r,
+		const PianoJsonType_t type) {
+	if (PianoJsonPeek (r) != type || r->depth >= PIANO_JSON_MAXDEPTH) {
+		return PianoJsonFail (r);
+	}
+	++r->pos;
+	++r->depth;
+	r->first = true;
+	return true;
+}
+
+/*	enter object, fails if next value is not an object
+ */
+bool PianoJsonObjectBegin (PianoJsonReader_t * const r) {
+	return PianoJsonBegin (r, PIANO_JSON_OBJECT);
+}
+
+/*	enter array, fails if next value is not an array
+ */
+bool PianoJsonArrayBegin (PianoJsonReader_t * const r) {
+	return PianoJsonBegin (r, PIANO_JSON_ARRAY);
+}
+
+/*	move to next container item, leaves the object/array at its end
+ *	@return true if there is another item
+ */
+static bool PianoJsonNext (PianoJsonReader_t * const r, const char close) {
+	if (r->error) {
+		return false;
+	}
+
+	PianoJsonSpace (r);
+	if (*r->pos == close) {
+		++r->pos;
+		--r->depth;
+		r->first = false;
+		return false;
+	}
+	if (!r->first) {
+		if (*r->pos != ',') {
+			return PianoJsonFail (r);
+		}
+		++r->pos;
+		PianoJsonSpace (r);
+	}
+	r->first = false;
+	return true;
+}
+
+/*	move to next object member, its name is stored in r->key
+ *	@return true if there is another member, its value must be consumed
+ */
+bool PianoJsonObjectNext (PianoJsonReader_t * const r) {
+	if (!PianoJsonNext (r, '}')) {
+		return false;
+	}
+
+	if (*r->pos != '"') {
+		return PianoJsonFail (r);
+	}
+	const char * const end = PianoJsonStringComplete (r);
+	size_t len;
+	if (end == NULL) {
+		return PianoJsonFail (r);
+	}
+	const char * const start = r->pos+1;
+	if (end - start < (ptrdiff_t) sizeof (r->key)) {
+		if (!PianoJsonUnescape (start, end, r->key, &len)) {
+			return PianoJsonFail (r);
+		}
+	} else {
+		/* nothing we are interested in */
+		if (!PianoJsonUnescape (start, end, NULL, &len)) {
+			return PianoJsonFail (r);
+		}
+		r->key[0] = '\0';
+	}
+	r->pos = end+1;
+
+	PianoJsonSpace (r);
+	if (*r->pos != ':') {
+		return PianoJsonFail (r);
+	}
+	++r->pos;
+	return true;
+}
+
+/*	move to next array element
+ *	@return true if there is another element, it must be consumed
+ */
+bool PianoJsonArrayNext (PianoJsonReader_t * const r) {
+	return PianoJsonNext (r, ']');
+}
+
+/*	consume next value of any type
+ */
+void PianoJsonSkip (PianoJsonReader_t * const r) {
+	bool isDouble;
+	size_t len;
+
+	switch (PianoJsonPeek (r)) {
+		case PIANO_JSON_OBJECT:
+			PianoJsonObjectBegin (r);
+			while (PianoJsonObjectNext (r)) {
+				PianoJsonSkip (r);
+			}
+			break;
+
+		case PIANO_JSON_ARRAY:
+			PianoJsonArrayBegin (r);
+			while (PianoJsonArrayNext (r)) {
+				PianoJsonSkip (r);
+			}
+			break;
+
+		case PIANO_JSON_STRING:
+			PianoJsonString (r, NULL, &len, false);
+			break;
+
+		case PIANO_JSON_NUMBER:
+			PianoJsonNumber (r, &isDouble);
+			break;
+
+		case PIANO_JSON_BOOLEAN:
+			if (*r->pos == 't') {
+				PianoJsonLiteral (r, "true");
+			} else {
+				PianoJsonLiteral (r, "false");
+			}
+			break;
+
+		case PIANO_JSON_NULL:
+			PianoJsonLiteral (r, "null");
+			break;
+
+		default:
+			PianoJsonFail (r);
+			break;
+	}
+}
+
+static char *PianoJsonReadStringAlloc (PianoJsonReader_t * const r,
+		const bool useAlloc) {
+	char *ret = NULL;
+	size_t len;
+
+	switch (PianoJsonPeek (r)) {
+		case PIANO_JSON_STRING:
+			PianoJsonString (r, &ret, &len, useAlloc);
+			break;
+
+		case PIANO_JSON_NULL:
+			PianoJsonLiteral (r, "null");
+			break;
+
+		default:
+			PianoJsonFail (r);
+			break;
+	}
+	return ret;
+}
+
+/*	read string value
+ *	@return string allocated with r->alloc or malloc, NULL for null; other
+ *		types are an error
+ */
+char *PianoJsonReadString (PianoJsonReader_t * const r) {
+	return PianoJsonReadStringAlloc (r, true);
+}
+
+/*	read string value that is only needed temporarily, like
+ *	PianoJsonReadString, but always allocated with malloc
+ */
+char *PianoJsonReadStringTemp (PianoJsonReader_t * const r) {
+	return PianoJsonReadStringAlloc (r, false);
+}
+
+/*	read boolean value, converting like json_object_get_boolean
+ */
+bool PianoJsonReadBool (PianoJsonReader_t * const r) {
+	bool isDouble;
+	size_t len;
+	const char *num;
+
+	switch (PianoJsonPeek (r)) {
+		case PIANO_JSON_BOOLEAN:
+			if (*r->pos == 't') {
+				return PianoJsonLiteral (r, "true");
+			} else {
+				PianoJsonLiteral (r, "false");
+				return false;
+			}
+
+		case PIANO_JSON_NUMBER:
+			if ((num = PianoJsonNumber (r, &isDouble)) == NULL) {
+				return false;
+			}
+			return isDouble ? strtod (num, NULL) != 0.0 :
+					strtoll (num, NULL, 10) != 0;
+
+		case PIANO_JSON_STRING:
+			return PianoJsonString (r, NULL, &len, false) && len != 0;
+
+		case PIANO_JSON_NULL:
+			PianoJsonLiteral (r, "null");
+			return false;
+
+		default:
+			return PianoJsonFail (r);
+	}
+}
+
+/*	read integer value, converting like json_object_get_int. Strings are an
+ *	error.
+ */
+int PianoJsonReadInt (PianoJsonReader_t * const r) {
+	bool isDouble;
+	const char *num;
+
+	switch (PianoJsonPeek (r)) {
+		case PIANO_JSON_NUMBER:
+			if ((num = PianoJsonNumber (r, &isDouble)) == NULL) {
+				return 0;
+			}
+			if (isDouble) {
+				const double d = strtod (num, NULL);
+				if (d <= INT32_MIN) {
+					return INT32_MIN;
+				} else if (d >= INT32_MAX) {
+					return INT32_MAX;
+				}
+				return (int32_t) d;
+			} else {
+				const long long i = strtoll (num, NULL, 10);
+				if (i <= INT32_MIN) {
+					return INT32_MIN;
+				} else if (i >= INT32_MAX) {
+					return INT32_MAX;
+				}
+				return (int32_t) i;
+			}
+
+		case PIANO_JSON_BOOLEAN:
+			return PianoJsonReadBool (r);
+
+		case PIANO_JSON_NULL:
+			PianoJsonLiteral (r, "null");
+			return 0;
+
+		default:
+			PianoJsonFail (r);
+			return 0;
+	}
+}
+
+/*	read floating point value, converting like json_object_get_double
+ */
+double PianoJsonReadDouble (PianoJsonReader_t * const r) {
+	bool isDouble;
+	const char *num;
+	char *s = NULL, *end;
+	size_t len;
+	double d;
+
+	switch (PianoJsonPeek (r)) {
+		case PIANO_JSON_NUMBER:
+			if ((num = PianoJsonNumber (r, &isDouble)) == NULL) {
+				return 0.0;
+			}
+			return isDouble ? strtod (num, NULL) :
+					(double) strtoll (num, NULL, 10);
+
+		case PIANO_JSON_STRING:
+			if (!PianoJsonString (r, &s, &len, false)) {
+				return 0.0;
+			}
+			errno = 0;
+			d = strtod (s, &end);
+			if (end == s || *end != '\0' ||
+					((d == HUGE_VAL || d == -HUGE_VAL) && errno == ERANGE)) {
+				d = 0.0;
+			}
+			free (s);
+			return d;
+
+		case PIANO_JSON_BOOLEAN:
+			return PianoJsonReadBool (r) ? 1.0 : 0.0;
+
+		case PIANO_JSON_NULL:
+			PianoJsonLiteral (r, "null");
+			return 0.0;
+
+		default:
+			PianoJsonFail (r);
+			return 0.0;
+	}
+}
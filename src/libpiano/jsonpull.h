@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* pull parser reading json straight from the response buffer, without
+ * building a tree. Only strict RFC 8259 input is accepted; anything else
+ * sets error, so callers can hand the response to json-c instead. The text
+ * does not have to be complete, see more. */
+typedef enum {
+	PIANO_JSON_INVALID = 0,
+	PIANO_JSON_OBJECT,
+	PIANO_JSON_ARRAY,
+	PIANO_JSON_STRING,
+	PIANO_JSON_NUMBER,
+	PIANO_JSON_BOOLEAN,
+	PIANO_JSON_NULL,
+} PianoJsonType_t;
+
+typedef struct {
+	const char *pos;
+	/* start of text, pos is relative to it if text moves */
+	const char *text;
+	unsigned int depth;
+	/* next member/element is the first one of its container */
+	bool first;
+	bool error;
+	/* allocator for PianoJsonReadString, malloc if NULL */
+	void *(*alloc) (void * const, const size_t);
+	void *allocData;
+	/* called when the parser hits the end of text, appends to it and
+	 * stores its (possibly moved) start. Returns false if there is no more
+	 * text. May be NULL for text that is complete. */
+	bool (*more) (void * const, const char ** const);
+	void *moreData;
+	/* current object member name, truncated names are set to "" */
+	char key[64];
+} PianoJsonReader_t;
+
+void PianoJsonInit (PianoJsonReader_t * const, const char * const);
+PianoJsonType_t PianoJsonPeek (PianoJsonReader_t * const);
+bool PianoJsonObjectBegin (PianoJsonReader_t * const);
+bool PianoJsonObjectNext (PianoJsonReader_t * const);
+bool PianoJsonArrayBegin (PianoJsonReader_t * const);
+bool PianoJsonArrayNext (PianoJsonReader_t * const);
+void PianoJsonSkip (PianoJsonReader_t * const);
+char *PianoJsonReadString (PianoJsonReader_t * const);
+char *PianoJsonReadStringTemp (PianoJsonReader_t * const);
+bool PianoJsonReadBool (PianoJsonReader_t * const);
+int PianoJsonReadInt (PianoJsonReader_t * const);
+double PianoJsonReadDouble (PianoJsonReader_t * const);
@@ -27,7 +27,8 @@ THE SOFTWARE.
 
 #define PianoListForeach(l) for (; (l) != NULL; (l) = (void *) (l)->next)
 
-/*	append element e to list l, return new list head
+/*	append element e to list l, return new list head. Walks to the tail,
+ *	building a list this way is quadratic, see PianoListPush
  */
 void *PianoListAppend (PianoListHead_t * const l, PianoListHead_t * const e) {
 	assert (e != NULL);
@@ -110,3 +111,61 @@ size_t PianoListCount (const PianoListHead_t * const l) {
 	return count;
 }
 
+
+/*	set up tracked list t from regular list l (may be NULL)
+ */
+void PianoListInit (PianoList_t * const t, PianoListHead_t * const l) {
+	assert (t != NULL);
+
+	PianoListHead_t *curr = l;
+
+	t->first = l;
+	t->last = NULL;
+	t->count = 0;
+	PianoListForeach (curr) {
+		t->last = curr;
+		++t->count;
+	}
+}
+
+/*	append element e to tracked list t in constant time, return new list head
+ */
+void *PianoListPush (PianoList_t * const t, PianoListHead_t * const e) {
+	assert (t != NULL);
+	assert (e != NULL);
+	assert (e->next == NULL);
+
+	if (t->last == NULL) {
+		t->first = e;
+	} else {
+		t->last->next = e;
+	}
+	t->last = e;
+	++t->count;
+
+	return t->first;
+}
+
+/*	move all elements of tracked list t to the end of list l, t is empty
+ *	afterwards. Walks l to its tail like PianoListAppend, so joining into a
+ *	growing list again and again (per page of a response, say) is still
+ *	quadratic in its length
+ *	@return new list head
+ */
+void *PianoListJoin (PianoListHead_t * const l, PianoList_t * const t) {
+	assert (t != NULL);
+
+	PianoListHead_t *ret = t->first;
+
+	if (l != NULL) {
+		PianoListHead_t *curr = l;
+		while (curr->next != NULL) {
+			curr = curr->next;
+		}
+		curr->next = t->first;
+		ret = l;
+	}
+	PianoListInit (t, NULL);
+
+	return ret;
+}
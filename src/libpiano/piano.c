@@ -62,16 +62,20 @@ PianoReturn_t PianoInit (PianoHandle_t *ph, const char *partnerUser,
 
 /*	destroy artist linked list
  */
-static void PianoDestroyArtists (PianoArtist_t *artists) {
+void PianoDestroyArtists (PianoArtist_t *artists) {
 	PianoArtist_t *curArtist, *lastArtist;
 
 	curArtist = artists;
 	while (curArtist != NULL) {
-		free (curArtist->name);
-		free (curArtist->musicId);
-		free (curArtist->seedId);
 		lastArtist = curArtist;
 		curArtist = (PianoArtist_t *) curArtist->head.next;
+		if (lastArtist->arena != NULL) {
+			PianoArenaUnref (lastArtist->arena);
+			continue;
+		}
+		free (lastArtist->name);
+		free (lastArtist->musicId);
+		free (lastArtist->seedId);
 		free (lastArtist);
 	}
 }
@@ -98,7 +102,7 @@ void PianoDestroyStation (PianoStation_t *station) {
 /*	free complete station list
  *	@param piano handle
  */
-static void PianoDestroyStations (PianoStation_t *stations) {
+void PianoDestroyStations (PianoStation_t *stations) {
 	PianoStation_t *curStation, *lastStation;
 
 	curStation = stations;
@@ -120,19 +124,26 @@ void PianoDestroyPlaylist (PianoSong_t *playlist) {
 
 	curSong = playlist;
 	while (curSong != NULL) {
-		free (curSong->audioUrl);
-		free (curSong->coverArt);
-		free (curSong->artist);
-		free (curSong->musicId);
-		free (curSong->title);
-		free (curSong->stationId);
-		free (curSong->album);
-		free (curSong->feedbackId);
-		free (curSong->seedId);
-		free (curSong->detailUrl);
-		free (curSong->trackToken);
 		lastSong = curSong;
 		curSong = (PianoSong_t *) curSong->head.next;
+		/* shared with other songs, see PianoStrIntern */
+		PianoStrRelease (lastSong->artist);
+		PianoStrRelease (lastSong->album);
+		PianoStrRelease (lastSong->stationId);
+		PianoStrRelease (lastSong->coverArt);
+		if (lastSong->arena != NULL) {
+			/* strings are owned by the arena too */
+			PianoArenaUnref (lastSong->arena);
+			continue;
+		}
+		free (lastSong->audioUrl);
+		free (lastSong->musicId);
+		free (lastSong->title);
+		free (lastSong->feedbackId);
+		free (lastSong->seedId);
+		free (lastSong->detailUrl);
+		free (lastSong->trackToken);
+		free (lastSong->songIdentity);
 		free (lastSong);
 	}
 }
@@ -151,19 +162,44 @@ static void PianoDestroyGenres (PianoGenre_t *genres) {
 
 	curGenre = genres;
 	while (curGenre != NULL) {
-		free (curGenre->name);
-		free (curGenre->musicId);
 		lastGenre = curGenre;
 		curGenre = (PianoGenre_t *) curGenre->head.next;
+		if (lastGenre->arena != NULL) {
+			PianoArenaUnref (lastGenre->arena);
+			continue;
+		}
+		free (lastGenre->name);
+		free (lastGenre->musicId);
 		free (lastGenre);
 	}
 }
 
+/*	destroy genre stations
+ */
+void PianoDestroyGenreCategories (PianoGenreCategory_t *categories) {
+	PianoGenreCategory_t *curGenreCat = categories, *lastGenreCat;
+
+	while (curGenreCat != NULL) {
+		PianoDestroyGenres (curGenreCat->genres);
+		lastGenreCat = curGenreCat;
+		curGenreCat = (PianoGenreCategory_t *) curGenreCat->head.next;
+		if (lastGenreCat->arena != NULL) {
+			PianoArenaUnref (lastGenreCat->arena);
+			continue;
+		}
+		free (lastGenreCat->name);
+		free (lastGenreCat);
+	}
+}
+
 /*	destroy user information
  */
 void PianoDestroyUserInfo (PianoUserInfo_t *user) {
 	free (user->authToken);
 	free (user->listenerId);
+	free (user->authPrefix);
+	free (user->urlSuffix);
+	memset (user, 0, sizeof (*user));
 }
 
 /*	destroy partner
@@ -173,6 +209,7 @@ static void PianoDestroyPartner (PianoPartner_t *partner) {
 	free (partner->password);
 	free (partner->device);
 	free (partner->authToken);
+	free (partner->urlSuffix);
 	PianoCryptDestroy (partner->in);
 	PianoCryptDestroy (partner->out);
 	memset (partner, 0, sizeof (*partner));
@@ -185,19 +222,31 @@ static void PianoDestroyPartner (PianoPartner_t *partner) {
 void PianoDestroy (PianoHandle_t *ph) {
 	PianoDestroyUserInfo (&ph->user);
 	PianoDestroyStations (ph->stations);
+	free (ph->stationIndex.slots);
 	PianoDestroyPartner (&ph->partner);
-	/* destroy genre stations */
-	PianoGenreCategory_t *curGenreCat = ph->genreStations, *lastGenreCat;
-	while (curGenreCat != NULL) {
-		PianoDestroyGenres (curGenreCat->genres);
-		free (curGenreCat->name);
-		lastGenreCat = curGenreCat;
-		curGenreCat = (PianoGenreCategory_t *) curGenreCat->head.next;
-		free (lastGenreCat);
-	}
+	PianoDestroyGenreCategories (ph->genreStations);
 	memset (ph, 0, sizeof (*ph));
 }
 
+/*	prepare request for reuse, post and response data buffers are kept
+ *	@param piano request
+ */
+void PianoResetRequest (PianoRequest_t *req) {
+	req->data = NULL;
+	req->secure = false;
+	req->urlPath[0] = '\0';
+	if (req->postData != NULL) {
+		req->postData[0] = '\0';
+	}
+	if (req->responseData != NULL) {
+		req->responseData[0] = '\0';
+	}
+	req->responseDataLength = 0;
+	req->responseDataExpected = 0;
+	req->receive = NULL;
+	req->receiveData = NULL;
+}
+
 /*	destroy request, free post data. req->responseData is *not* freed here, as
  *	it might be allocated by something else than malloc!
  *	@param piano request
@@ -230,6 +279,151 @@ PianoStation_t *PianoFindStationById (PianoStation_t * const stations,
 	return NULL;
 }
 
+/* FNV-1a */
+static size_t PianoStationIndexHash (const char *id) {
+	uint32_t hash = 2166136261u;
+
+	while (*id != '\0') {
+		hash ^= (unsigned char) *id++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/*	insert station into table, which must have a free slot
+ */
+static void PianoStationIndexPut (PianoStationIndex_t * const index,
+		PianoStation_t * const station) {
+	const size_t mask = index->size-1;
+	size_t i = PianoStationIndexHash (station->id) & mask;
+
+	while (index->slots[i] != NULL) {
+		i = (i+1) & mask;
+	}
+	index->slots[i] = station;
+	++index->count;
+}
+
+/*	add station to index, unless there is one with the same token already
+ *	(PianoFindStationById returns the first one too)
+ *	@param piano handle
+ *	@param station, which must be part of ph->stations
+ */
+void PianoStationIndexAdd (PianoHandle_t * const ph,
+		PianoStation_t * const station) {
+	PianoStationIndex_t * const index = &ph->stationIndex;
+
+	assert (station != NULL);
+
+	if (station->id == NULL || index->incomplete ||
+			PianoLookupStationById (ph, station->id) != NULL) {
+		return;
+	}
+
+	/* keep load factor below 1/2 */
+	if ((index->count+1)*2 > index->size) {
+		const size_t newSize = index->size == 0 ? 64 : index->size*2;
+		PianoStation_t ** const oldSlots = index->slots;
+		const size_t oldSize = index->size;
+
+		if ((index->slots = calloc (newSize, sizeof (*index->slots))) == NULL) {
+			/* give up, lookups fall back to the list */
+			free (oldSlots);
+			memset (index, 0, sizeof (*index));
+			index->incomplete = true;
+			return;
+		}
+		index->size = newSize;
+		index->count = 0;
+		for (size_t i = 0; i < oldSize; i++) {
+			if (oldSlots[i] != NULL) {
+				PianoStationIndexPut (index, oldSlots[i]);
+			}
+		}
+		free (oldSlots);
+	}
+
+	PianoStationIndexPut (index, station);
+}
+
+/*	remove station from index. A station with the same token still in
+ *	ph->stations takes its place.
+ *	@param piano handle
+ *	@param station, already unlinked from ph->stations
+ */
+void PianoStationIndexRemove (PianoHandle_t * const ph,
+		PianoStation_t * const station) {
+	PianoStationIndex_t * const index = &ph->stationIndex;
+
+	assert (station != NULL);
+
+	if (station->id == NULL || index->size == 0) {
+		return;
+	}
+
+	const size_t mask = index->size-1;
+	size_t i = PianoStationIndexHash (station->id) & mask;
+	while (index->slots[i] != station) {
+		if (index->slots[i] == NULL) {
+			/* not indexed, i.e. a duplicate */
+			return;
+		}
+		i = (i+1) & mask;
+	}
+
+	/* backward shift deletion, keeps probe sequences intact */
+	index->slots[i] = NULL;
+	--index->count;
+	for (size_t j = (i+1) & mask; index->slots[j] != NULL; j = (j+1) & mask) {
+		const size_t k = PianoStationIndexHash (index->slots[j]->id) & mask;
+		/* can slot j move to i without breaking its probe sequence? */
+		if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j)) {
+			index->slots[i] = index->slots[j];
+			index->slots[j] = NULL;
+			i = j;
+		}
+	}
+
+	if (ph->stations != NULL) {
+		PianoStation_t * const other = PianoFindStationById (ph->stations,
+				station->id);
+		if (other != NULL) {
+			PianoStationIndexAdd (ph, other);
+		}
+	}
+}
+
+/*	get station of handle by id, constant time version of
+ *	PianoFindStationById (ph->stations, searchStation)
+ *	@param piano handle
+ *	@param search for this
+ *	@return the first station structure matching the given id
+ */
+PianoStation_t *PianoLookupStationById (const PianoHandle_t * const ph,
+		const char * const searchStation) {
+	assert (ph != NULL);
+
+	const PianoStationIndex_t * const index = &ph->stationIndex;
+
+	if (searchStation == NULL || ph->stations == NULL) {
+		return NULL;
+	} else if (index->incomplete) {
+		return PianoFindStationById (ph->stations, searchStation);
+	} else if (index->size == 0) {
+		return NULL;
+	}
+
+	const size_t mask = index->size-1;
+	for (size_t i = PianoStationIndexHash (searchStation) & mask;
+			index->slots[i] != NULL; i = (i+1) & mask) {
+		if (strcmp (index->slots[i]->id, searchStation) == 0) {
+			return index->slots[i];
+		}
+	}
+
+	return NULL;
+}
+
 /*	convert return value to human-readable string
  *	@param enum
  *	@return error string
@@ -27,6 +27,7 @@ THE SOFTWARE.
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <time.h>
 
 /* this is our public API; don't expect this api to be stable as long as
  * pandora does not provide a stable api
@@ -46,9 +47,23 @@ typedef struct PianoListHead {
 	struct PianoListHead *next;
 } PianoListHead_t;
 
+/* memory shared by the objects of one response, see arena.c */
+typedef struct PianoArena PianoArena_t;
+
+/* regular list plus its tail and length, for constant time appends */
+typedef struct {
+	PianoListHead_t *first, *last;
+	size_t count;
+} PianoList_t;
+
 typedef struct PianoUserInfo {
 	char *listenerId;
 	char *authToken;
+	/* encrypted, hex-encoded request body prefix containing authToken,
+	 * built on first use */
+	char *authPrefix;
+	/* url query following the method name, set by login */
+	char *urlSuffix;
 } PianoUserInfo_t;
 
 typedef struct PianoStation {
@@ -61,6 +76,14 @@ typedef struct PianoStation {
 	char *seedId;
 } PianoStation_t;
 
+/* hash table over the handle’s station list, keyed by station token */
+typedef struct {
+	PianoStation_t **slots;
+	size_t size, count;
+	/* an insert failed, lookups have to search the list */
+	bool incomplete;
+} PianoStationIndex_t;
+
 typedef enum {
 	PIANO_RATE_NONE = 0,
 	PIANO_RATE_LOVE = 1,
@@ -95,10 +118,13 @@ typedef struct PianoSong {
 	char *feedbackId;
 	char *detailUrl;
 	char *trackToken;
+	char *songIdentity; /* same for every play of a track */
 	float fileGain;
 	unsigned int length; /* song length in seconds */
+	time_t fetched; /* when audioUrl was received, it expires eventually */
 	PianoSongRating_t rating;
 	PianoAudioFormat_t audioFormat;
+	PianoArena_t *arena; /* owner of this struct and its strings or NULL */
 } PianoSong_t;
 
 /* currently only used for search results */
@@ -108,31 +134,39 @@ typedef struct PianoArtist {
 	char *musicId;
 	char *seedId;
 	int score;
+	PianoArena_t *arena;
 } PianoArtist_t;
 
 typedef struct PianoGenre {
 	PianoListHead_t head;
 	char *name;
 	char *musicId;
+	PianoArena_t *arena;
 } PianoGenre_t;
 
 typedef struct PianoGenreCategory {
 	PianoListHead_t head;
 	char *name;
 	PianoGenre_t *genres;
+	PianoArena_t *arena;
 } PianoGenreCategory_t;
 
 typedef struct PianoPartner {
 	PianoCipher_t in, out;
 	char *authToken, *device, *user, *password;
 	unsigned int id;
+	/* url query following the method name, for user login */
+	char *urlSuffix;
 } PianoPartner_t;
 
 typedef struct PianoHandle {
 	PianoUserInfo_t user;
 	/* linked lists */
 	PianoStation_t *stations;
+	/* length of stations */
+	size_t stationCount;
 	PianoGenreCategory_t *genreStations;
+	PianoStationIndex_t stationIndex;
 	PianoPartner_t partner;
 	int timeOffset;
 } PianoHandle_t;
@@ -180,15 +214,6 @@ typedef enum {
 	PIANO_REQUEST_CHANGE_SETTINGS = 24,
 } PianoRequestType_t;
 
-typedef struct PianoRequest {
-	PianoRequestType_t type;
-	bool secure;
-	void *data;
-	char urlPath[1024];
-	char *postData;
-	char *responseData;
-} PianoRequest_t;
-
 /* request data structures */
 typedef struct {
 	char *user;
@@ -324,6 +349,29 @@ typedef enum {
 	PIANO_RET_P_RATE_LIMIT = PIANO_RET_OFFSET+1039,
 } PianoReturn_t;
 
+typedef struct PianoRequest {
+	PianoRequestType_t type;
+	bool secure;
+	void *data;
+	char urlPath[1024];
+	char *postData;
+	char *responseData;
+	/* bytes in responseData, without the terminating NUL */
+	size_t responseDataLength;
+	/* size of the complete response if the transport knows it in advance
+	 * (Content-Length of an uncompressed body), 0 otherwise */
+	size_t responseDataExpected;
+	/* allocated size of postData/responseData, both buffers are reused
+	 * by the next request after PianoResetRequest */
+	size_t postDataCapacity, responseDataCapacity;
+	/* if set, responseData is still being received and PianoResponse parses
+	 * it while it arrives: receive appends the next piece (responseData may
+	 * move) and returns PIANO_RET_CONTINUE_REQUEST, PIANO_RET_OK once the
+	 * response is complete or PIANO_RET_NETWORK_ERROR */
+	PianoReturn_t (*receive) (struct PianoRequest *);
+	void *receiveData;
+} PianoRequest_t;
+
 /* list stuff */
 #ifndef __GNUC__
 #  define __attribute__(x)
@@ -346,6 +394,16 @@ void *PianoListPrepend (PianoListHead_t * const l, PianoListHead_t * const e)
 void *PianoListGet (PianoListHead_t * const l, const size_t n);
 #define PianoListGetP(l,n) PianoListGet (&(l)->head, n)
 #define PianoListForeachP(l) for (; (l) != NULL; (l) = (void *) (l)->head.next)
+void PianoListInit (PianoList_t * const t, PianoListHead_t * const l);
+#define PianoListInitP(t,l) PianoListInit ((t), ((l) == NULL) ? NULL : \
+		&(l)->head)
+void *PianoListPush (PianoList_t * const t, PianoListHead_t * const e);
+#define PianoListPushP(t,e) PianoListPush ((t), &(e)->head)
+#define PianoListSize(t) ((t)->count)
+void *PianoListJoin (PianoListHead_t * const l, PianoList_t * const t)
+		__attribute__ ((warn_unused_result));
+#define PianoListJoinP(l,t) PianoListJoin (((l) == NULL) ? NULL : \
+		&(l)->head, (t))
 
 /* memory management */
 PianoReturn_t PianoInit (PianoHandle_t *, const char *,
@@ -360,10 +418,13 @@ void PianoDestroyStationInfo (PianoStationInfo_t *);
 PianoReturn_t PianoRequest (PianoHandle_t *, PianoRequest_t *,
 		PianoRequestType_t);
 PianoReturn_t PianoResponse (PianoHandle_t *, PianoRequest_t *);
+void PianoResetRequest (PianoRequest_t *);
 void PianoDestroyRequest (PianoRequest_t *);
 
 /* misc */
 PianoStation_t *PianoFindStationById (PianoStation_t * const,
 		const char * const);
+PianoStation_t *PianoLookupStationById (const PianoHandle_t * const,
+		const char * const);
 const char *PianoErrorToStr (PianoReturn_t);
 
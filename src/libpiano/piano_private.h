@@ -26,5 +26,23 @@ THE SOFTWARE.
 #include "piano.h"
 
 void PianoDestroyStation (PianoStation_t *station);
+void PianoDestroyStations (PianoStation_t *stations);
+void PianoDestroyArtists (PianoArtist_t *artists);
+void PianoDestroyGenreCategories (PianoGenreCategory_t *categories);
+
+void PianoStationIndexAdd (PianoHandle_t * const, PianoStation_t * const);
+void PianoStationIndexRemove (PianoHandle_t * const, PianoStation_t * const);
+
+PianoArena_t *PianoArenaNew (size_t const);
+void *PianoArenaAlloc (PianoArena_t * const, size_t const);
+char *PianoArenaStrdup (PianoArena_t * const, const char * const);
+void *PianoArenaObject (PianoArena_t * const, size_t const);
+void PianoArenaUnref (PianoArena_t * const);
+
+char *PianoStrIntern (const char * const);
+void PianoStrRelease (char * const);
 void PianoDestroyUserInfo (PianoUserInfo_t *user);
 
+char *PianoUrlSuffix (const char * const, const unsigned int,
+		const char * const);
+
@@ -23,56 +23,271 @@ THE SOFTWARE.
 
 #include "../config.h"
 
-#include <json/json.h>
 #include <assert.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#include "piano.h"
+#include "piano_private.h"
 #include "crypt.h"
 
-static char* PianoEncodeAuthToken(const char* token)
-{
+/*	build url query following the method name, with the percent-encoded
+ *	auth token. Called once per login, not per request.
+ *	@param partner or user auth token
+ *	@param partner id
+ *	@param user id, NULL for the partner’s query
+ *	@return query string or NULL if out of memory
+ */
+char *PianoUrlSuffix (const char * const authToken,
+		const unsigned int partnerId, const char * const userId) {
 	/* Pandora expects '+' and '=' to be escaped. */
-	const char* allowed = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-~._";
-	const char* hex     = "0123456789ABCDEF";
-
-	size_t i, tokenSize, resultSize, resultCapacity;
-	char* result;
-
-	tokenSize      = strlen(token);
-	resultSize     = 0;
-	resultCapacity = tokenSize * 3 / 2;
-	result         = malloc(resultCapacity);
-	for (i = 0; i < tokenSize; ++i) {
-		char cp = token[i];
-		
-		int c = (strchr(allowed, cp) != NULL) ? 1 : 3;
-
-		if (resultSize + c >= resultCapacity) {
-			resultCapacity = resultCapacity * 3 / 2;
-			result = realloc(result, resultCapacity);
+	static const char allowed[] = "abcdefghijklmnopqrstuvwxyz"
+			"ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-~._";
+	static const char hex[] = "0123456789ABCDEF";
+
+	assert (authToken != NULL);
+
+	const size_t tokenLen = strlen (authToken);
+	char * const encoded = malloc (tokenLen*3 + 1);
+	if (encoded == NULL) {
+		return NULL;
+	}
+
+	char *out = encoded;
+	for (size_t i = 0; i < tokenLen; i++) {
+		const unsigned char c = authToken[i];
+		if (memchr (allowed, c, sizeof (allowed)-1) != NULL) {
+			*out++ = c;
+		} else {
+			*out++ = '%';
+			*out++ = hex[c >> 4];
+			*out++ = hex[c & 0xf];
 		}
+	}
+	*out = '\0';
+
+	const char * const userKey = userId == NULL ? "" : "&user_id=";
+	const char * const userValue = userId == NULL ? "" : userId;
+	const int len = snprintf (NULL, 0, "&auth_token=%s&partner_id=%i%s%s",
+			encoded, partnerId, userKey, userValue);
+	char * const ret = len < 0 ? NULL : malloc (len + 1);
+	if (ret != NULL) {
+		snprintf (ret, len + 1, "&auth_token=%s&partner_id=%i%s%s", encoded,
+				partnerId, userKey, userValue);
+	}
+	free (encoded);
+
+	return ret;
+}
 
-		if (c == 1) {
-			result[resultSize++] = cp;
+/* request body written straight to a growable buffer. Output is identical
+ * to json-c’s json_object_to_json_string, which the api has been fed so
+ * far. */
+typedef struct {
+	char *buf;
+	/* buf is NUL-terminated at len */
+	size_t len, size;
+	/* no member/element in current container yet */
+	bool first;
+	bool error;
+} PianoJsonWriter_t;
+
+/*	make room for n more bytes and the terminating NUL
+ *	@return false if out of memory
+ */
+static bool PianoJsonWriterReserve (PianoJsonWriter_t * const w,
+		const size_t n) {
+	if (w->error) {
+		return false;
+	}
+	if (w->len + n + 1 > w->size) {
+		size_t size = w->size == 0 ? 256 : w->size;
+		while (w->len + n + 1 > size) {
+			size *= 2;
 		}
-		else {
-			result[resultSize++] = '%';
-			result[resultSize++] = hex[(cp >> 4) & 0x0F];
-			result[resultSize++] = hex[(cp >> 0) & 0x0F];
+		char * const buf = realloc (w->buf, size);
+		if (buf == NULL) {
+			w->error = true;
+			return false;
 		}
+		w->buf = buf;
+		w->size = size;
+	}
+	return true;
+}
+
+static void PianoJsonWriterRaw (PianoJsonWriter_t * const w,
+		const char * const s, const size_t len) {
+	if (PianoJsonWriterReserve (w, len)) {
+		memcpy (&w->buf[w->len], s, len);
+		w->len += len;
+		w->buf[w->len] = '\0';
+	}
+}
+
+/*	write quoted string, escaped like json-c (including the slash)
+ */
+static void PianoJsonWriterString (PianoJsonWriter_t * const w,
+		const char * const s) {
+	static const char hex[] = "0123456789abcdef";
+
+	assert (s != NULL);
+
+	/* worst case every byte becomes \u00XX */
+	if (!PianoJsonWriterReserve (w, strlen (s)*6 + 2)) {
+		return;
+	}
+
+	char *out = &w->buf[w->len];
+	*out++ = '"';
+	for (const unsigned char *in = (const unsigned char *) s; *in != '\0';
+			in++) {
+		const unsigned char c = *in;
+		switch (c) {
+			case '\b': *out++ = '\\'; *out++ = 'b'; break;
+			case '\n': *out++ = '\\'; *out++ = 'n'; break;
+			case '\r': *out++ = '\\'; *out++ = 'r'; break;
+			case '\t': *out++ = '\\'; *out++ = 't'; break;
+			case '\f': *out++ = '\\'; *out++ = 'f'; break;
+			case '"':
+			case '\\':
+			case '/':
+				*out++ = '\\';
+				*out++ = c;
+				break;
+
+			default:
+				if (c < ' ') {
+					memcpy (out, "\\u00", 4);
+					out[4] = hex[c >> 4];
+					out[5] = hex[c & 0xf];
+					out += 6;
+				} else {
+					*out++ = c;
+				}
+				break;
+		}
+	}
+	*out++ = '"';
+	*out = '\0';
+	w->len = out - w->buf;
+}
+
+/*	start object or array
+ */
+static void PianoJsonWriterOpen (PianoJsonWriter_t * const w, const char c) {
+	PianoJsonWriterRaw (w, &c, 1);
+	w->first = true;
+}
+
+/*	end object or array, json-c puts a blank before the bracket even if
+ *	it is empty
+ */
+static void PianoJsonWriterClose (PianoJsonWriter_t * const w, const char c) {
+	const char end[] = {' ', c};
+	PianoJsonWriterRaw (w, end, sizeof (end));
+	w->first = false;
+}
+
+/*	separate next member/element from the previous one
+ */
+static void PianoJsonWriterNext (PianoJsonWriter_t * const w) {
+	if (w->first) {
+		PianoJsonWriterRaw (w, " ", 1);
+		w->first = false;
+	} else {
+		PianoJsonWriterRaw (w, ", ", 2);
+	}
+}
+
+static void PianoJsonWriterKey (PianoJsonWriter_t * const w,
+		const char * const key) {
+	PianoJsonWriterNext (w);
+	PianoJsonWriterString (w, key);
+	PianoJsonWriterRaw (w, ": ", 2);
+}
+
+static void PianoJsonAddString (PianoJsonWriter_t * const w,
+		const char * const key, const char * const value) {
+	PianoJsonWriterKey (w, key);
+	PianoJsonWriterString (w, value);
+}
+
+static void PianoJsonAddBool (PianoJsonWriter_t * const w,
+		const char * const key, const bool value) {
+	PianoJsonWriterKey (w, key);
+	if (value) {
+		PianoJsonWriterRaw (w, "true", 4);
+	} else {
+		PianoJsonWriterRaw (w, "false", 5);
 	}
+}
 
-	if (resultSize + 1 >= resultCapacity) {
-		resultCapacity = resultSize + 1;
-		result = realloc(result, resultCapacity);
+static void PianoJsonAddInt (PianoJsonWriter_t * const w,
+		const char * const key, const int64_t value) {
+	char buf[32];
+	const int len = snprintf (buf, sizeof (buf), "%" PRId64, value);
+
+	assert (len > 0 && (size_t) len < sizeof (buf));
+	PianoJsonWriterKey (w, key);
+	PianoJsonWriterRaw (w, buf, len);
+}
+
+/*	get request body prefix carrying the user auth token, encrypted and
+ *	hex-encoded. The plaintext is padded with whitespace to a multiple of the
+ *	cipher block size, so its ECB ciphertext does not depend on the rest of
+ *	the body and is reused for every request of the session.
+ *	@param piano handle
+ *	@return cached prefix or NULL
+ */
+static const char *PianoRequestAuthPrefix (PianoHandle_t *ph) {
+	assert (ph->user.authToken != NULL);
+
+	if (ph->user.authPrefix != NULL) {
+		return ph->user.authPrefix;
 	}
 
-	result[resultSize] = 0;
+	/* object stays open, the request’s members follow */
+	PianoJsonWriter_t w = {0};
+	PianoJsonWriterOpen (&w, '{');
+	PianoJsonAddString (&w, "userAuthToken", ph->user.authToken);
+	PianoJsonWriterRaw (&w, ",", 1);
+	while (w.len % 8 != 0) {
+		PianoJsonWriterRaw (&w, " ", 1);
+	}
 
-	return result;
+	if (!w.error) {
+		ph->user.authPrefix = PianoEncryptString (ph->partner.out, w.buf);
+	}
+	free (w.buf);
+
+	return ph->user.authPrefix;
+}
+
+/*	start request body with the cached auth token prefix, the members
+ *	written afterwards are encrypted in place by PianoRequestFinish
+ *	@param piano handle
+ *	@param writer
+ *	@param corrected timestamp
+ *	@return offset of the plaintext
+ */
+static size_t PianoRequestBeginWithAuth (PianoHandle_t *ph,
+		PianoJsonWriter_t * const w, const time_t timestamp) {
+	const char * const prefix = PianoRequestAuthPrefix (ph);
+	if (prefix == NULL) {
+		w->error = true;
+		return 0;
+	}
+
+	PianoJsonWriterRaw (w, prefix, strlen (prefix));
+	const size_t start = w->len;
+	/* prefix opened the object already */
+	w->first = true;
+	PianoJsonAddInt (w, "syncTime", timestamp);
+
+	return start;
 }
 
 /*	prepare piano request (initializes request type, urlpath and postData)
@@ -83,9 +298,12 @@ static char* PianoEncodeAuthToken(const char* token)
 PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 		PianoRequestType_t type) {
 	PianoReturn_t ret = PIANO_RET_OK;
-	const char *jsonSendBuf;
 	const char *method = NULL;
-	json_object *j = json_object_new_object ();
+	/* body is written to the request’s old buffer, if any */
+	PianoJsonWriter_t w = {.buf = req->postData,
+			.size = req->postDataCapacity};
+	/* start of plaintext to be encrypted */
+	size_t plainStart = 0;
 	/* corrected timestamp */
 	time_t timestamp = time (NULL) - ph->timeOffset;
 	bool encrypted = true;
@@ -97,6 +315,11 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 	/* no tls by default */
 	req->secure = false;
 
+	if (type != PIANO_REQUEST_LOGIN && type != PIANO_REQUEST_RATE_SONG) {
+		/* method call, userAuthToken and syncTime come first */
+		plainStart = PianoRequestBeginWithAuth (ph, &w, timestamp);
+	}
+
 	switch (req->type) {
 		case PIANO_REQUEST_LOGIN: {
 			/* authenticate user */
@@ -104,48 +327,36 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (logindata != NULL);
 
+			PianoJsonWriterOpen (&w, '{');
 			switch (logindata->step) {
 				case 0:
 					encrypted = false;
 					req->secure = true;
 
-					json_object_object_add (j, "username",
-							json_object_new_string (ph->partner.user));
-					json_object_object_add (j, "password",
-							json_object_new_string (ph->partner.password));
-					json_object_object_add (j, "deviceModel",
-							json_object_new_string (ph->partner.device));
-					json_object_object_add (j, "version",
-							json_object_new_string ("5"));
-					json_object_object_add (j, "includeUrls",
-							json_object_new_boolean (true));
+					PianoJsonAddString (&w, "username", ph->partner.user);
+					PianoJsonAddString (&w, "password", ph->partner.password);
+					PianoJsonAddString (&w, "deviceModel", ph->partner.device);
+					PianoJsonAddString (&w, "version", "5");
+					PianoJsonAddBool (&w, "includeUrls", true);
 					snprintf (req->urlPath, sizeof (req->urlPath),
 							PIANO_RPC_PATH "method=auth.partnerLogin");
 					break;
 
 				case 1: {
-					char *urlencAuthToken;
-
 					req->secure = true;
 
-					json_object_object_add (j, "loginType",
-							json_object_new_string ("user"));
-					json_object_object_add (j, "username",
-							json_object_new_string (logindata->user));
-					json_object_object_add (j, "password",
-							json_object_new_string (logindata->password));
-					json_object_object_add (j, "partnerAuthToken",
-							json_object_new_string (ph->partner.authToken));
-					json_object_object_add (j, "syncTime",
-							json_object_new_int64 (timestamp));
-
-					urlencAuthToken = PianoEncodeAuthToken (ph->partner.authToken);
-					assert (urlencAuthToken != NULL);
+					PianoJsonAddString (&w, "loginType", "user");
+					PianoJsonAddString (&w, "username", logindata->user);
+					PianoJsonAddString (&w, "password", logindata->password);
+					PianoJsonAddString (&w, "partnerAuthToken",
+							ph->partner.authToken);
+					PianoJsonAddInt (&w, "syncTime", timestamp);
+
+					/* set by partner login */
+					assert (ph->partner.urlSuffix != NULL);
 					snprintf (req->urlPath, sizeof (req->urlPath),
-							PIANO_RPC_PATH "method=auth.userLogin&"
-							"auth_token=%s&partner_id=%i", urlencAuthToken,
-							ph->partner.id);
-					free (urlencAuthToken);
+							PIANO_RPC_PATH "method=auth.userLogin%s",
+							ph->partner.urlSuffix);
 
 					break;
 				}
@@ -157,8 +368,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			/* get stations, user must be authenticated */
 			assert (ph->user.listenerId != NULL);
 
-			json_object_object_add (j, "returnAllStations",
-					json_object_new_boolean (true));
+			PianoJsonAddBool (&w, "returnAllStations", true);
 
 			method = "user.getStationList";
 			break;
@@ -174,10 +384,8 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			req->secure = true;
 
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (reqData->station->id));
-			json_object_object_add (j, "includeTrackLength",
-					json_object_new_boolean (true));
+			PianoJsonAddString (&w, "stationToken", reqData->station->id);
+			PianoJsonAddBool (&w, "includeTrackLength", true);
 
 			method = "station.getPlaylist";
 			break;
@@ -193,12 +401,10 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData->rating != PIANO_RATE_NONE &&
 					reqData->rating != PIANO_RATE_TIRED);
 
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (reqData->stationId));
-			json_object_object_add (j, "trackToken",
-					json_object_new_string (reqData->trackToken));
-			json_object_object_add (j, "isPositive",
-					json_object_new_boolean (reqData->rating == PIANO_RATE_LOVE));
+			PianoJsonAddString (&w, "stationToken", reqData->stationId);
+			PianoJsonAddString (&w, "trackToken", reqData->trackToken);
+			PianoJsonAddBool (&w, "isPositive",
+					reqData->rating == PIANO_RATE_LOVE);
 
 			method = "station.addFeedback";
 			break;
@@ -211,10 +417,8 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData->station != NULL);
 			assert (reqData->newName != NULL);
 
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (reqData->station->id));
-			json_object_object_add (j, "stationName",
-					json_object_new_string (reqData->newName));
+			PianoJsonAddString (&w, "stationToken", reqData->station->id);
+			PianoJsonAddString (&w, "stationName", reqData->newName);
 
 			method = "station.renameStation";
 			break;
@@ -227,8 +431,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (station != NULL);
 			assert (station->id != NULL);
 
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (station->id));
+			PianoJsonAddString (&w, "stationToken", station->id);
 
 			method = "station.deleteStation";
 			break;
@@ -241,8 +444,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData != NULL);
 			assert (reqData->searchStr != NULL);
 
-			json_object_object_add (j, "searchText",
-					json_object_new_string (reqData->searchStr));
+			PianoJsonAddString (&w, "searchText", reqData->searchStr);
 
 			method = "music.search";
 			break;
@@ -256,20 +458,16 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData->token != NULL);
 
 			if (reqData->type == PIANO_MUSICTYPE_INVALID) {
-				json_object_object_add (j, "musicToken",
-						json_object_new_string (reqData->token));
+				PianoJsonAddString (&w, "musicToken", reqData->token);
 			} else {
-				json_object_object_add (j, "trackToken",
-						json_object_new_string (reqData->token));
+				PianoJsonAddString (&w, "trackToken", reqData->token);
 				switch (reqData->type) {
 					case PIANO_MUSICTYPE_SONG:
-						json_object_object_add (j, "musicType",
-								json_object_new_string ("song"));
+						PianoJsonAddString (&w, "musicType", "song");
 						break;
 
 					case PIANO_MUSICTYPE_ARTIST:
-						json_object_object_add (j, "musicType",
-								json_object_new_string ("artist"));
+						PianoJsonAddString (&w, "musicType", "artist");
 						break;
 
 					default:
@@ -290,10 +488,8 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData->station != NULL);
 			assert (reqData->musicId != NULL);
 
-			json_object_object_add (j, "musicToken",
-					json_object_new_string (reqData->musicId));
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (reqData->station->id));
+			PianoJsonAddString (&w, "musicToken", reqData->musicId);
+			PianoJsonAddString (&w, "stationToken", reqData->station->id);
 
 			method = "station.addMusic";
 			break;
@@ -305,8 +501,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (song != NULL);
 
-			json_object_object_add (j, "trackToken",
-					json_object_new_string (song->trackToken));
+			PianoJsonAddString (&w, "trackToken", song->trackToken);
 
 			method = "user.sleepSong";
 			break;
@@ -316,17 +511,17 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			/* select stations included in quickmix (see useQuickMix flag of
 			 * PianoStation_t) */
 			PianoStation_t *curStation = ph->stations;
-			json_object *a = json_object_new_array ();
 
+			PianoJsonWriterKey (&w, "quickMixStationIds");
+			PianoJsonWriterOpen (&w, '[');
 			PianoListForeachP (curStation) {
 				/* quick mix can't contain itself */
 				if (curStation->useQuickMix && !curStation->isQuickMix) {
-					json_object_array_add (a,
-							json_object_new_string (curStation->id));
+					PianoJsonWriterNext (&w);
+					PianoJsonWriterString (&w, curStation->id);
 				}
 			}
-
-			json_object_object_add (j, "quickMixStationIds", a);
+			PianoJsonWriterClose (&w, ']');
 
 			method = "user.setQuickMix";
 			break;
@@ -344,8 +539,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (station != NULL);
 
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (station->id));
+			PianoJsonAddString (&w, "stationToken", station->id);
 
 			method = "station.transformSharedStation";
 			break;
@@ -358,8 +552,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData != NULL);
 			assert (reqData->song != NULL);
 
-			json_object_object_add (j, "trackToken",
-					json_object_new_string (reqData->song->trackToken));
+			PianoJsonAddString (&w, "trackToken", reqData->song->trackToken);
 
 			method = "track.explainTrack";
 			break;
@@ -371,8 +564,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (song != NULL);
 
-			json_object_object_add (j, "trackToken",
-					json_object_new_string (song->trackToken));
+			PianoJsonAddString (&w, "trackToken", song->trackToken);
 
 			method = "bookmark.addSongBookmark";
 			break;
@@ -384,8 +576,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (song != NULL);
 
-			json_object_object_add (j, "trackToken",
-					json_object_new_string (song->trackToken));
+			PianoJsonAddString (&w, "trackToken", song->trackToken);
 
 			method = "bookmark.addArtistBookmark";
 			break;
@@ -398,12 +589,9 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData != NULL);
 			assert (reqData->station != NULL);
 
-			json_object_object_add (j, "stationToken",
-					json_object_new_string (reqData->station->id));
-			json_object_object_add (j, "includeExtendedAttributes",
-					json_object_new_boolean (true));
-			json_object_object_add (j, "includeExtraParams",
-					json_object_new_boolean (true));
+			PianoJsonAddString (&w, "stationToken", reqData->station->id);
+			PianoJsonAddBool (&w, "includeExtendedAttributes", true);
+			PianoJsonAddBool (&w, "includeExtraParams", true);
 
 			method = "station.getStation";
 			break;
@@ -414,8 +602,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (song != NULL);
 
-			json_object_object_add (j, "feedbackId",
-					json_object_new_string (song->feedbackId));
+			PianoJsonAddString (&w, "feedbackId", song->feedbackId);
 
 			method = "station.deleteFeedback";
 			break;
@@ -439,8 +626,7 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 
 			assert (seedId != NULL);
 
-			json_object_object_add (j, "seedId",
-					json_object_new_string (seedId));
+			PianoJsonAddString (&w, "seedId", seedId);
 
 			method = "station.deleteMusic";
 			break;
@@ -457,23 +643,20 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			assert (reqData->currentPassword != NULL);
 			assert (reqData->currentUsername != NULL);
 
-			json_object_object_add (j, "userInitiatedChange",
-					json_object_new_boolean (true));
-			json_object_object_add (j, "currentUsername",
-					json_object_new_string (reqData->currentUsername));
-			json_object_object_add (j, "currentPassword",
-					json_object_new_string (reqData->currentPassword));
+			PianoJsonAddBool (&w, "userInitiatedChange", true);
+			PianoJsonAddString (&w, "currentUsername",
+					reqData->currentUsername);
+			PianoJsonAddString (&w, "currentPassword",
+					reqData->currentPassword);
 
 			if (reqData->explicitContentFilter != PIANO_UNDEFINED) {
-				json_object_object_add (j, "isExplicitContentFilterEnabled",
-						json_object_new_boolean (
-						reqData->explicitContentFilter == PIANO_TRUE));
+				PianoJsonAddBool (&w, "isExplicitContentFilterEnabled",
+						reqData->explicitContentFilter == PIANO_TRUE);
 			}
 
 #define changeIfSet(field) \
 	if (reqData->field != NULL) { \
-		json_object_object_add (j, #field, \
-				json_object_new_string (reqData->field)); \
+		PianoJsonAddString (&w, #field, reqData->field); \
 	}
 
 			changeIfSet (newUsername);
@@ -508,46 +691,35 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			req->type = PIANO_REQUEST_RATE_SONG;
 			req->data = reqData;
 
-			goto cleanup;
-			break;
+			return ret;
 		}
 	}
 
 	/* standard parameter */
 	if (method != NULL) {
-		char *urlencAuthToken;
-
-		assert (ph->user.authToken != NULL);
-
-		urlencAuthToken = PianoEncodeAuthToken (ph->user.authToken);
-		assert (urlencAuthToken != NULL);
+		/* set by user login */
+		assert (ph->user.urlSuffix != NULL);
 
 		snprintf (req->urlPath, sizeof (req->urlPath), PIANO_RPC_PATH
-				"method=%s&auth_token=%s&partner_id=%i&user_id=%s", method,
-				urlencAuthToken, ph->partner.id, ph->user.listenerId);
-
-		free (urlencAuthToken);
-
-		json_object_object_add (j, "userAuthToken",
-				json_object_new_string (ph->user.authToken));
-		json_object_object_add (j, "syncTime",
-				json_object_new_int64 (timestamp));
+				"method=%s%s", method, ph->user.urlSuffix);
 	}
 
-	/* json to string */
-	jsonSendBuf = json_object_to_json_string (j);
+	PianoJsonWriterClose (&w, '}');
+
 	if (encrypted) {
-		if ((req->postData = PianoEncryptString (ph->partner.out,
-				jsonSendBuf)) == NULL) {
-			ret = PIANO_RET_OUT_OF_MEMORY;
+		/* the body is encrypted where it is, after the cached prefix */
+		const size_t plainLen = w.len - plainStart;
+		PianoJsonWriterReserve (&w, PianoEncryptedSize (plainLen) - plainLen);
+		if (!w.error && !PianoEncryptInPlace (ph->partner.out,
+				&w.buf[plainStart], plainLen)) {
+			w.error = true;
 		}
-	} else {
-		req->postData = strdup (jsonSendBuf);
 	}
 
-cleanup:
-	json_object_put (j);
+	/* the request owns the buffer, even if the body is incomplete */
+	req->postData = w.buf;
+	req->postDataCapacity = w.size;
 
-	return ret;
+	return w.error ? PIANO_RET_OUT_OF_MEMORY : ret;
 }
 
@@ -32,19 +32,78 @@ THE SOFTWARE.
 #include "piano.h"
 #include "piano_private.h"
 #include "crypt.h"
+#include "jsonpull.h"
 
-static char *PianoJsonStrdup (json_object *j, const char *key) {
+/*	copy string value of key
+ *	@param arena to allocate from, malloc if NULL
+ */
+static char *PianoJsonStrdup (PianoArena_t * const arena, json_object *j,
+		const char *key) {
 	assert (j != NULL);
 	assert (key != NULL);
 
 	json_object *v;
 	if (json_object_object_get_ex (j, key, &v)) {
-		return strdup (json_object_get_string (v));
+		const char * const s = json_object_get_string (v);
+		return arena == NULL ? strdup (s) : PianoArenaStrdup (arena, s);
 	} else {
 		return NULL;
 	}
 }
 
+/*	get shared copy of string value, see PianoStrIntern
+ */
+static char *PianoJsonIntern (json_object *j, const char *key) {
+	assert (j != NULL);
+	assert (key != NULL);
+
+	json_object *v;
+	if (json_object_object_get_ex (j, key, &v)) {
+		return PianoStrIntern (json_object_get_string (v));
+	} else {
+		return NULL;
+	}
+}
+
+/* first arena chunk if the response size is unknown, about half of a
+ * playlist */
+#define PIANO_RESPONSE_ARENA_BLOCK (4*1024)
+
+/*	create arena for results handed out to the caller. Stations stay
+ *	malloc’ed, because they are renamed in place.
+ *	@return arena or NULL if not used for this request
+ */
+static PianoArena_t *PianoResponseArena (const PianoRequest_t * const req) {
+	/* while receiving, responseDataLength is only what arrived so far */
+	size_t size = PIANO_RESPONSE_ARENA_BLOCK*2;
+	if (req->receive == NULL) {
+		size = req->responseDataLength;
+	} else if (req->responseDataExpected != 0) {
+		size = req->responseDataExpected;
+	}
+
+	switch (req->type) {
+		case PIANO_REQUEST_GET_PLAYLIST:
+		case PIANO_REQUEST_SEARCH:
+		case PIANO_REQUEST_GET_GENRE_STATIONS:
+		case PIANO_REQUEST_GET_STATION_INFO:
+			/* songs keep well under half of the response (most of it is
+			 * skipped, artist and album are shared), the arena grows if
+			 * that is not enough */
+			return PianoArenaNew (size/2);
+
+		default:
+			return NULL;
+	}
+}
+
+/*	allocate zeroed result object, from arena if not NULL
+ */
+static void *PianoResponseObject (PianoArena_t * const arena,
+		const size_t size) {
+	return arena == NULL ? calloc (1, size) : PianoArenaObject (arena, size);
+}
+
 static bool getBoolDefault (json_object * const j, const char * const key, const bool def) {
 	assert (j != NULL);
 	assert (key != NULL);
@@ -58,8 +117,8 @@ static bool getBoolDefault (json_object * const j, const char * const key, const
 }
 
 static void PianoJsonParseStation (json_object *j, PianoStation_t *s) {
-	s->name = PianoJsonStrdup (j, "stationName");
-	s->id = PianoJsonStrdup (j, "stationToken");
+	s->name = PianoJsonStrdup (NULL, j, "stationName");
+	s->id = PianoJsonStrdup (NULL, j, "stationToken");
 	s->isCreator = !getBoolDefault (j, "isShared", !false);
 	s->isQuickMix = getBoolDefault (j, "isQuickMix", false);
 }
@@ -88,10 +147,712 @@ static void PianoStrpcat (char * restrict dest, const char * restrict src,
 	*dest = '\0';
 }
 
+/* state of streaming parser, lists are moved to their final destination
+ * only if the whole response is valid */
+typedef struct {
+	char **ids;
+	size_t count;
+} PianoStreamIds_t;
+
+typedef struct {
+	PianoRequest_t *req;
+	PianoArena_t *arena;
+	/* GET_STATIONS */
+	PianoList_t stations;
+	PianoStreamIds_t mix;
+	/* GET_PLAYLIST */
+	PianoList_t playlist;
+	bool haveItems, qualityUnavailable;
+	/* GET_GENRE_STATIONS */
+	PianoList_t categories;
+	/* GET_STATION_INFO */
+	PianoList_t songSeeds, artistSeeds, feedback[2];
+} PianoStream_t;
+
+/*	free string, unless it lives in an arena
+ */
+static void PianoStreamRelease (PianoJsonReader_t * const r,
+		char ** const s) {
+	if (r->alloc == NULL) {
+		free (*s);
+	}
+	*s = NULL;
+}
+
+/*	replace string with next value, like json-c the last duplicate key wins
+ */
+static void PianoStreamString (PianoJsonReader_t * const r, char ** const dest) {
+	PianoStreamRelease (r, dest);
+	*dest = PianoJsonReadString (r);
+}
+
+/*	replace song metadata with shared copy of next value
+ */
+static void PianoStreamIntern (PianoJsonReader_t * const r, char ** const dest) {
+	char * const s = PianoJsonReadStringTemp (r);
+
+	PianoStrRelease (*dest);
+	*dest = PianoStrIntern (s);
+	free (s);
+}
+
+static void *PianoStreamAlloc (void * const arena, const size_t size) {
+	return PianoArenaAlloc (arena, size);
+}
+
+/*	enter object, skip any other value (json-c lookups on those fail)
+ *	@return true if object was entered
+ */
+static bool PianoStreamObject (PianoJsonReader_t * const r) {
+	if (PianoJsonPeek (r) == PIANO_JSON_OBJECT) {
+		return PianoJsonObjectBegin (r);
+	}
+	PianoJsonSkip (r);
+	return false;
+}
+
+/*	duplicate container keys are left to json-c
+ */
+static bool PianoStreamOnce (PianoJsonReader_t * const r, bool * const seen) {
+	if (*seen) {
+		r->error = true;
+		return false;
+	}
+	*seen = true;
+	return true;
+}
+
+static void PianoStreamIdsDestroy (PianoStreamIds_t * const ids) {
+	for (size_t i = 0; i < ids->count; i++) {
+		free (ids->ids[i]);
+	}
+	free (ids->ids);
+	memset (ids, 0, sizeof (*ids));
+}
+
+/*	read array of strings
+ */
+static void PianoStreamIdsRead (PianoJsonReader_t * const r,
+		PianoStreamIds_t * const ids) {
+	size_t size = 0;
+
+	PianoStreamIdsDestroy (ids);
+	PianoJsonArrayBegin (r);
+	while (PianoJsonArrayNext (r)) {
+		char * const id = PianoJsonReadString (r);
+		if (id == NULL) {
+			r->error = true;
+			break;
+		}
+		if (ids->count == size) {
+			size = size == 0 ? 8 : size*2;
+			char ** const newIds = realloc (ids->ids, size * sizeof (*newIds));
+			if (newIds == NULL) {
+				free (id);
+				r->error = true;
+				break;
+			}
+			ids->ids = newIds;
+		}
+		ids->ids[ids->count++] = id;
+	}
+}
+
+static void PianoStreamStations (PianoJsonReader_t * const r,
+		PianoStream_t * const st) {
+	bool seen = false;
+
+	while (PianoJsonObjectNext (r)) {
+		if (strcmp (r->key, "stations") != 0 || !PianoStreamOnce (r, &seen)) {
+			PianoJsonSkip (r);
+			continue;
+		}
+
+		PianoJsonArrayBegin (r);
+		while (PianoJsonArrayNext (r)) {
+			PianoStation_t *s;
+			PianoStreamIds_t ids = {NULL, 0};
+
+			if ((s = calloc (1, sizeof (*s))) == NULL) {
+				r->error = true;
+				break;
+			}
+			PianoListPushP (&st->stations, s);
+
+			if (PianoStreamObject (r)) {
+				while (PianoJsonObjectNext (r)) {
+					if (strcmp (r->key, "stationName") == 0) {
+						PianoStreamString (r, &s->name);
+					} else if (strcmp (r->key, "stationToken") == 0) {
+						PianoStreamString (r, &s->id);
+					} else if (strcmp (r->key, "isShared") == 0) {
+						s->isCreator = !PianoJsonReadBool (r);
+					} else if (strcmp (r->key, "isQuickMix") == 0) {
+						s->isQuickMix = PianoJsonReadBool (r);
+					} else if (strcmp (r->key, "quickMixStationIds") == 0) {
+						PianoStreamIdsRead (r, &ids);
+					} else {
+						PianoJsonSkip (r);
+					}
+				}
+			}
+
+			if (s->isQuickMix) {
+				/* fix flags on other stations later */
+				PianoStreamIdsDestroy (&st->mix);
+				st->mix = ids;
+			} else {
+				PianoStreamIdsDestroy (&ids);
+			}
+		}
+	}
+}
+
+/*	parse audioUrlMap, sets audio url and format of song
+ *	@return true if the requested quality is available
+ */
+static bool PianoStreamUrlMap (PianoJsonReader_t * const r,
+		PianoSong_t * const song, const char * const quality) {
+	static const char *formatMap[] = {"", "aacplus", "mp3"};
+	bool ret = false;
+
+	PianoStreamRelease (r, &song->audioUrl);
+	song->audioFormat = PIANO_AF_UNKNOWN;
+
+	PianoJsonObjectBegin (r);
+	while (PianoJsonObjectNext (r)) {
+		if (strcmp (r->key, quality) != 0) {
+			PianoJsonSkip (r);
+			continue;
+		}
+
+		char *encoding = NULL;
+		bool haveEncoding = false;
+
+		PianoStreamRelease (r, &song->audioUrl);
+		song->audioFormat = PIANO_AF_UNKNOWN;
+		if (PianoStreamObject (r)) {
+			while (PianoJsonObjectNext (r)) {
+				if (strcmp (r->key, "encoding") == 0) {
+					haveEncoding = true;
+					free (encoding);
+					encoding = PianoJsonReadStringTemp (r);
+				} else if (strcmp (r->key, "audioUrl") == 0) {
+					PianoStreamString (r, &song->audioUrl);
+				} else {
+					PianoJsonSkip (r);
+				}
+			}
+		}
+
+		ret = haveEncoding;
+		if (haveEncoding) {
+			for (size_t k = 0; encoding != NULL &&
+					k < sizeof (formatMap)/sizeof (*formatMap); k++) {
+				if (strcmp (formatMap[k], encoding) == 0) {
+					song->audioFormat = k;
+					break;
+				}
+			}
+		} else {
+			PianoStreamRelease (r, &song->audioUrl);
+		}
+		free (encoding);
+	}
+
+	return ret;
+}
+
+static void PianoStreamPlaylist (PianoJsonReader_t * const r,
+		PianoStream_t * const st) {
+	const PianoRequestDataGetPlaylist_t * const reqData = st->req->data;
+	static const char *qualityMap[] = {"", "lowQuality", "mediumQuality",
+			"highQuality"};
+
+	assert (reqData->quality < sizeof (qualityMap)/sizeof (*qualityMap));
+
+	while (PianoJsonObjectNext (r)) {
+		if (strcmp (r->key, "items") != 0 ||
+				!PianoStreamOnce (r, &st->haveItems)) {
+			PianoJsonSkip (r);
+			continue;
+		}
+
+		PianoJsonArrayBegin (r);
+		while (PianoJsonArrayNext (r)) {
+			PianoSong_t *song;
+			bool haveArtist = false, haveUrlMap = false, haveQuality = false;
+
+			if (st->qualityUnavailable) {
+				/* result is discarded, just validate the rest */
+				PianoJsonSkip (r);
+				continue;
+			}
+
+			if ((song = PianoResponseObject (st->arena,
+					sizeof (*song))) == NULL) {
+				r->error = true;
+				break;
+			}
+			song->arena = st->arena;
+			song->fetched = time (NULL);
+
+			if (PianoStreamObject (r)) {
+				while (PianoJsonObjectNext (r)) {
+					const char * const key = r->key;
+					if (strcmp (key, "artistName") == 0) {
+						haveArtist = true;
+						PianoStreamIntern (r, &song->artist);
+					} else if (strcmp (key, "albumName") == 0) {
+						PianoStreamIntern (r, &song->album);
+					} else if (strcmp (key, "songName") == 0) {
+						PianoStreamString (r, &song->title);
+					} else if (strcmp (key, "trackToken") == 0) {
+						PianoStreamString (r, &song->trackToken);
+					} else if (strcmp (key, "stationId") == 0) {
+						PianoStreamIntern (r, &song->stationId);
+					} else if (strcmp (key, "albumArtUrl") == 0) {
+						PianoStreamIntern (r, &song->coverArt);
+					} else if (strcmp (key, "songDetailUrl") == 0) {
+						PianoStreamString (r, &song->detailUrl);
+					} else if (strcmp (key, "songIdentity") == 0) {
+						PianoStreamString (r, &song->songIdentity);
+					} else if (strcmp (key, "trackGain") == 0) {
+						song->fileGain = (float) PianoJsonReadDouble (r);
+					} else if (strcmp (key, "trackLength") == 0) {
+						song->length = PianoJsonReadInt (r);
+					} else if (strcmp (key, "songRating") == 0) {
+						song->rating = PianoJsonReadInt (r) == 1 ?
+								PIANO_RATE_LOVE : PIANO_RATE_NONE;
+					} else if (strcmp (key, "audioUrlMap") == 0) {
+						haveUrlMap = true;
+						haveQuality = PianoStreamUrlMap (r, song,
+								qualityMap[reqData->quality]);
+					} else {
+						PianoJsonSkip (r);
+					}
+				}
+			}
+
+			if (!haveArtist) {
+				/* ads and other non-song items */
+				PianoDestroyPlaylist (song);
+			} else if (haveUrlMap && !haveQuality) {
+				st->qualityUnavailable = true;
+				PianoDestroyPlaylist (song);
+			} else {
+				PianoListPushP (&st->playlist, song);
+			}
+		}
+	}
+}
+
+static void PianoStreamGenres (PianoJsonReader_t * const r,
+		PianoStream_t * const st) {
+	bool seen = false;
+
+	while (PianoJsonObjectNext (r)) {
+		if (strcmp (r->key, "categories") != 0 || !PianoStreamOnce (r, &seen)) {
+			PianoJsonSkip (r);
+			continue;
+		}
+
+		PianoJsonArrayBegin (r);
+		while (PianoJsonArrayNext (r)) {
+			PianoGenreCategory_t *category;
+			PianoList_t genres;
+			bool seenStations = false;
+
+			if ((category = PianoResponseObject (st->arena,
+					sizeof (*category))) == NULL) {
+				r->error = true;
+				break;
+			}
+			category->arena = st->arena;
+			PianoListPushP (&st->categories, category);
+			PianoListInit (&genres, NULL);
+
+			if (!PianoStreamObject (r)) {
+				continue;
+			}
+			while (PianoJsonObjectNext (r)) {
+				if (strcmp (r->key, "categoryName") == 0) {
+					PianoStreamString (r, &category->name);
+					continue;
+				} else if (strcmp (r->key, "stations") != 0 ||
+						!PianoStreamOnce (r, &seenStations)) {
+					PianoJsonSkip (r);
+					continue;
+				}
+
+				PianoJsonArrayBegin (r);
+				while (PianoJsonArrayNext (r)) {
+					PianoGenre_t *genre;
+
+					if ((genre = PianoResponseObject (st->arena,
+							sizeof (*genre))) == NULL) {
+						r->error = true;
+						break;
+					}
+					genre->arena = st->arena;
+					category->genres = PianoListPushP (&genres, genre);
+
+					if (PianoStreamObject (r)) {
+						while (PianoJsonObjectNext (r)) {
+							if (strcmp (r->key, "stationName") == 0) {
+								PianoStreamString (r, &genre->name);
+							} else if (strcmp (r->key, "stationToken") == 0) {
+								PianoStreamString (r, &genre->musicId);
+							} else {
+								PianoJsonSkip (r);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/*	parse song seeds and artist seeds
+ */
+static void PianoStreamSeeds (PianoJsonReader_t * const r,
+		PianoStream_t * const st) {
+	bool seenSongs = false, seenArtists = false;
+
+	while (PianoJsonObjectNext (r)) {
+		if (strcmp (r->key, "songs") == 0 &&
+				PianoStreamOnce (r, &seenSongs)) {
+			PianoJsonArrayBegin (r);
+			while (PianoJsonArrayNext (r)) {
+				PianoSong_t *seedSong;
+
+				if ((seedSong = PianoResponseObject (st->arena,
+						sizeof (*seedSong))) == NULL) {
+					r->error = true;
+					break;
+				}
+				seedSong->arena = st->arena;
+				PianoListPushP (&st->songSeeds, seedSong);
+
+				if (PianoStreamObject (r)) {
+					while (PianoJsonObjectNext (r)) {
+						if (strcmp (r->key, "songName") == 0) {
+							PianoStreamString (r, &seedSong->title);
+						} else if (strcmp (r->key, "artistName") == 0) {
+							PianoStreamIntern (r, &seedSong->artist);
+						} else if (strcmp (r->key, "seedId") == 0) {
+							PianoStreamString (r, &seedSong->seedId);
+						} else {
+							PianoJsonSkip (r);
+						}
+					}
+				}
+			}
+		} else if (strcmp (r->key, "artists") == 0 &&
+				PianoStreamOnce (r, &seenArtists)) {
+			PianoJsonArrayBegin (r);
+			while (PianoJsonArrayNext (r)) {
+				PianoArtist_t *seedArtist;
+
+				if ((seedArtist = PianoResponseObject (st->arena,
+						sizeof (*seedArtist))) == NULL) {
+					r->error = true;
+					break;
+				}
+				seedArtist->arena = st->arena;
+				PianoListPushP (&st->artistSeeds, seedArtist);
+
+				if (PianoStreamObject (r)) {
+					while (PianoJsonObjectNext (r)) {
+						if (strcmp (r->key, "artistName") == 0) {
+							PianoStreamString (r, &seedArtist->name);
+						} else if (strcmp (r->key, "seedId") == 0) {
+							PianoStreamString (r, &seedArtist->seedId);
+						} else {
+							PianoJsonSkip (r);
+						}
+					}
+				}
+			}
+		} else {
+			PianoJsonSkip (r);
+		}
+	}
+}
+
+/*	parse thumbs up/down lists, kept apart because the json-c path always
+ *	returns thumbsUp first
+ */
+static void PianoStreamFeedback (PianoJsonReader_t * const r,
+		PianoStream_t * const st) {
+	static const char * const keys[] = {"thumbsUp", "thumbsDown"};
+	bool seen[] = {false, false};
+
+	while (PianoJsonObjectNext (r)) {
+		size_t i;
+		for (i = 0; i < sizeof (keys)/sizeof (*keys); i++) {
+			if (strcmp (r->key, keys[i]) == 0) {
+				break;
+			}
+		}
+		if (i == sizeof (keys)/sizeof (*keys) ||
+				!PianoStreamOnce (r, &seen[i])) {
+			PianoJsonSkip (r);
+			continue;
+		}
+
+		PianoJsonArrayBegin (r);
+		while (PianoJsonArrayNext (r)) {
+			PianoSong_t *feedbackSong;
+			bool isPositive = false;
+
+			if ((feedbackSong = PianoResponseObject (st->arena,
+					sizeof (*feedbackSong))) == NULL) {
+				r->error = true;
+				break;
+			}
+			feedbackSong->arena = st->arena;
+			PianoListPushP (&st->feedback[i], feedbackSong);
+
+			if (PianoStreamObject (r)) {
+				while (PianoJsonObjectNext (r)) {
+					if (strcmp (r->key, "songName") == 0) {
+						PianoStreamString (r, &feedbackSong->title);
+					} else if (strcmp (r->key, "artistName") == 0) {
+						PianoStreamIntern (r, &feedbackSong->artist);
+					} else if (strcmp (r->key, "feedbackId") == 0) {
+						PianoStreamString (r, &feedbackSong->feedbackId);
+					} else if (strcmp (r->key, "isPositive") == 0) {
+						isPositive = PianoJsonReadBool (r);
+					} else if (strcmp (r->key, "trackLength") == 0) {
+						feedbackSong->length = PianoJsonReadInt (r);
+					} else {
+						PianoJsonSkip (r);
+					}
+				}
+			}
+			feedbackSong->rating = isPositive ? PIANO_RATE_LOVE :
+					PIANO_RATE_BAN;
+		}
+	}
+}
+
+static void PianoStreamStationInfo (PianoJsonReader_t * const r,
+		PianoStream_t * const st) {
+	bool seenMusic = false, seenFeedback = false;
+
+	while (PianoJsonObjectNext (r)) {
+		if (strcmp (r->key, "music") == 0 &&
+				PianoStreamOnce (r, &seenMusic)) {
+			if (PianoStreamObject (r)) {
+				PianoStreamSeeds (r, st);
+			}
+		} else if (strcmp (r->key, "feedback") == 0 &&
+				PianoStreamOnce (r, &seenFeedback)) {
+			if (PianoStreamObject (r)) {
+				PianoStreamFeedback (r, st);
+			}
+		} else {
+			PianoJsonSkip (r);
+		}
+	}
+}
+
+/*	free everything not moved to its destination, except the arena itself
+ */
+static void PianoStreamDestroy (PianoStream_t * const st) {
+	PianoDestroyStations ((PianoStation_t *) st->stations.first);
+	PianoStreamIdsDestroy (&st->mix);
+	PianoDestroyPlaylist ((PianoSong_t *) st->playlist.first);
+	PianoDestroyGenreCategories ((PianoGenreCategory_t *)
+			st->categories.first);
+	PianoDestroyPlaylist ((PianoSong_t *) st->songSeeds.first);
+	PianoDestroyArtists ((PianoArtist_t *) st->artistSeeds.first);
+	for (size_t i = 0; i < sizeof (st->feedback)/sizeof (*st->feedback); i++) {
+		PianoDestroyPlaylist ((PianoSong_t *) st->feedback[i].first);
+	}
+}
+
+/*	jsonpull more callback, receives the next piece of the response
+ */
+static bool PianoStreamMore (void * const data, const char ** const text) {
+	PianoRequest_t * const req = data;
+
+	if (req->receive == NULL || req->receive (req) != PIANO_RET_CONTINUE_REQUEST) {
+		return false;
+	}
+	*text = req->responseData;
+	return true;
+}
+
+/*	receive whatever is left of the response
+ *	@return PIANO_RET_OK or PIANO_RET_NETWORK_ERROR
+ */
+static PianoReturn_t PianoResponseComplete (PianoRequest_t * const req) {
+	PianoReturn_t ret = PIANO_RET_OK;
+
+	if (req->receive != NULL) {
+		while ((ret = req->receive (req)) == PIANO_RET_CONTINUE_REQUEST) {
+		}
+	}
+	return ret;
+}
+
+/*	parse the largest and most frequent responses directly from the response
+ *	buffer, without building a json-c tree first. Results are identical to
+ *	the json-c path below, which handles everything this one does not
+ *	understand (errors, unusual json, duplicate containers, …).
+ *	@param piano handle
+ *	@param request
+ *	@param return value, if handled
+ *	@return false if the response has to be parsed with json-c
+ */
+static bool PianoResponseStream (PianoHandle_t *ph, PianoRequest_t *req,
+		PianoReturn_t * const ret) {
+	PianoJsonReader_t r;
+	PianoStream_t st;
+	bool haveStat = false, haveResult = false, statOk = false;
+
+	switch (req->type) {
+		case PIANO_REQUEST_GET_STATIONS:
+		case PIANO_REQUEST_GET_PLAYLIST:
+		case PIANO_REQUEST_GET_GENRE_STATIONS:
+		case PIANO_REQUEST_GET_STATION_INFO:
+			break;
+
+		default:
+			return false;
+	}
+
+	memset (&st, 0, sizeof (st));
+	st.req = req;
+	st.arena = PianoResponseArena (req);
+
+	PianoJsonInit (&r, req->responseData);
+	r.more = PianoStreamMore;
+	r.moreData = req;
+	if (st.arena != NULL) {
+		r.alloc = PianoStreamAlloc;
+		r.allocData = st.arena;
+	}
+	PianoJsonObjectBegin (&r);
+	while (PianoJsonObjectNext (&r)) {
+		if (strcmp (r.key, "stat") == 0 && PianoStreamOnce (&r, &haveStat)) {
+			char * const stat = PianoJsonReadStringTemp (&r);
+			statOk = stat != NULL && strcmp (stat, "ok") == 0;
+			free (stat);
+		} else if (strcmp (r.key, "result") == 0 &&
+				PianoStreamOnce (&r, &haveResult)) {
+			if (!PianoStreamObject (&r)) {
+				continue;
+			}
+			switch (req->type) {
+				case PIANO_REQUEST_GET_STATIONS:
+					PianoStreamStations (&r, &st);
+					break;
+
+				case PIANO_REQUEST_GET_PLAYLIST:
+					PianoStreamPlaylist (&r, &st);
+					break;
+
+				case PIANO_REQUEST_GET_GENRE_STATIONS:
+					PianoStreamGenres (&r, &st);
+					break;
+
+				case PIANO_REQUEST_GET_STATION_INFO:
+					PianoStreamStationInfo (&r, &st);
+					break;
+
+				default:
+					assert (0);
+					break;
+			}
+		} else {
+			PianoJsonSkip (&r);
+		}
+	}
+
+	if (r.error || !statOk) {
+		/* error responses are rare, let json-c deal with them */
+		PianoStreamDestroy (&st);
+		PianoArenaUnref (st.arena);
+		return false;
+	}
+
+	/* the connection is reusable only after the last byte was read */
+	if ((*ret = PianoResponseComplete (req)) != PIANO_RET_OK) {
+		PianoStreamDestroy (&st);
+		PianoArenaUnref (st.arena);
+		return true;
+	}
+
+	*ret = PIANO_RET_OK;
+	switch (req->type) {
+		case PIANO_REQUEST_GET_STATIONS: {
+			PianoStation_t *added = (PianoStation_t *) st.stations.first;
+			ph->stationCount += PianoListSize (&st.stations);
+			ph->stations = PianoListJoinP (ph->stations, &st.stations);
+			PianoListForeachP (added) {
+				PianoStationIndexAdd (ph, added);
+			}
+
+			/* fix quickmix flags */
+			for (size_t i = 0; i < st.mix.count; i++) {
+				PianoStation_t * const mixStation = PianoLookupStationById (ph,
+						st.mix.ids[i]);
+				if (mixStation != NULL) {
+					mixStation->useQuickMix = true;
+				}
+			}
+			break;
+		}
+
+		case PIANO_REQUEST_GET_PLAYLIST: {
+			PianoRequestDataGetPlaylist_t * const reqData = req->data;
+			if (st.qualityUnavailable) {
+				*ret = PIANO_RET_QUALITY_UNAVAILABLE;
+			} else if (st.haveItems) {
+				reqData->retPlaylist = (PianoSong_t *) st.playlist.first;
+				PianoListInit (&st.playlist, NULL);
+			}
+			break;
+		}
+
+		case PIANO_REQUEST_GET_GENRE_STATIONS:
+			ph->genreStations = PianoListJoinP (ph->genreStations,
+					&st.categories);
+			break;
+
+		case PIANO_REQUEST_GET_STATION_INFO: {
+			PianoRequestDataGetStationInfo_t * const reqData = req->data;
+			PianoStationInfo_t * const info = &reqData->info;
+			info->songSeeds = PianoListJoinP (info->songSeeds, &st.songSeeds);
+			info->artistSeeds = PianoListJoinP (info->artistSeeds,
+					&st.artistSeeds);
+			for (size_t i = 0; i < sizeof (st.feedback)/sizeof (*st.feedback);
+					i++) {
+				info->feedback = PianoListJoinP (info->feedback,
+						&st.feedback[i]);
+			}
+			break;
+		}
+
+		default:
+			assert (0);
+			break;
+	}
+	PianoStreamDestroy (&st);
+	PianoArenaUnref (st.arena);
+
+	return true;
+}
+
 /*	parse xml response and update data structures/return new data structure
  *	@param piano handle
  *	@param initialized request (expects responseData to be a NUL-terminated
- *			string)
+ *			string, responseDataLength its length; if receive is set, the
+ *			response is received while parsing)
  */
 PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 	PianoReturn_t ret = PIANO_RET_OK;
@@ -99,7 +860,16 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 	assert (ph != NULL);
 	assert (req != NULL);
 
+	if (PianoResponseStream (ph, req, &ret)) {
+		return ret;
+	}
+
+	if ((ret = PianoResponseComplete (req)) != PIANO_RET_OK) {
+		return ret;
+	}
+
 	json_object * const j = json_tokener_parse (req->responseData);
+	PianoArena_t * const arena = PianoResponseArena (req);
 
 	json_object *status;
 	if (!json_object_object_get_ex (j, "stat", &status)) {
@@ -169,28 +939,43 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						ret = PIANO_RET_CONTINUE_REQUEST;
 					}
 					free (decryptedTimestamp);
-					/* get auth token */
-					ph->partner.authToken = PianoJsonStrdup (result,
+					/* get auth token, replacing the one of an earlier login */
+					free (ph->partner.authToken);
+					free (ph->partner.urlSuffix);
+					ph->partner.urlSuffix = NULL;
+					ph->partner.authToken = PianoJsonStrdup (NULL, result,
 							"partnerAuthToken");
 					json_object *partnerId;
-					if (!json_object_object_get_ex (result, "partnerId", &partnerId)) {
+					if (!json_object_object_get_ex (result, "partnerId", &partnerId) ||
+							ph->partner.authToken == NULL) {
 						ret = PIANO_RET_INVALID_RESPONSE;
 						break;
 					}
 					ph->partner.id = json_object_get_int (partnerId);
+					if ((ph->partner.urlSuffix = PianoUrlSuffix (
+							ph->partner.authToken, ph->partner.id, NULL)) == NULL) {
+						ret = PIANO_RET_OUT_OF_MEMORY;
+						break;
+					}
 					++reqData->step;
 					break;
 				}
 
 				case 1:
 					/* information exists when reauthenticating, destroy to
-					 * avoid memleak */
-					if (ph->user.listenerId != NULL) {
-						PianoDestroyUserInfo (&ph->user);
-					}
-					ph->user.listenerId = PianoJsonStrdup (result, "userId");
-					ph->user.authToken = PianoJsonStrdup (result,
+					 * avoid memleak; drops the old token’s request prefix */
+					PianoDestroyUserInfo (&ph->user);
+					ph->user.listenerId = PianoJsonStrdup (NULL, result,
+							"userId");
+					ph->user.authToken = PianoJsonStrdup (NULL, result,
 							"userAuthToken");
+					if (ph->user.authToken == NULL) {
+						ret = PIANO_RET_INVALID_RESPONSE;
+					} else if ((ph->user.urlSuffix = PianoUrlSuffix (
+							ph->user.authToken, ph->partner.id,
+							ph->user.listenerId)) == NULL) {
+						ret = PIANO_RET_OUT_OF_MEMORY;
+					}
 					break;
 			}
 			break;
@@ -201,17 +986,23 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			assert (req->responseData != NULL);
 
 			json_object *stations, *mix = NULL;
+			PianoList_t stationList;
 
 			if (!json_object_object_get_ex (result, "stations", &stations)) {
 				break;
 			}
 
+			PianoListInitP (&stationList, ph->stations);
+
 			for (int i = 0; i < json_object_array_length (stations); i++) {
 				PianoStation_t *tmpStation;
 				json_object *s = json_object_array_get_idx (stations, i);
 
 				if ((tmpStation = calloc (1, sizeof (*tmpStation))) == NULL) {
-					return PIANO_RET_OUT_OF_MEMORY;
+					/* stations parsed so far are in the handle’s list and
+					 * index already, keep them */
+					ret = PIANO_RET_OUT_OF_MEMORY;
+					goto cleanup;
 				}
 
 				PianoJsonParseStation (s, tmpStation);
@@ -222,19 +1013,19 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 				}
 
 				/* start new linked list or append */
-				ph->stations = PianoListAppendP (ph->stations, tmpStation);
+				ph->stations = PianoListPushP (&stationList, tmpStation);
+				ph->stationCount = PianoListSize (&stationList);
+				PianoStationIndexAdd (ph, tmpStation);
 			}
 
 			/* fix quickmix flags */
 			if (mix != NULL) {
-				PianoStation_t *curStation = ph->stations;
-				PianoListForeachP (curStation) {
-					for (int i = 0; i < json_object_array_length (mix); i++) {
-						json_object *id = json_object_array_get_idx (mix, i);
-						if (strcmp (json_object_get_string (id),
-								curStation->id) == 0) {
-							curStation->useQuickMix = true;
-						}
+				for (int i = 0; i < json_object_array_length (mix); i++) {
+					json_object *id = json_object_array_get_idx (mix, i);
+					PianoStation_t * const mixStation = PianoLookupStationById (
+							ph, json_object_get_string (id));
+					if (mixStation != NULL) {
+						mixStation->useQuickMix = true;
 					}
 				}
 			}
@@ -245,6 +1036,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			/* get playlist, usually four songs */
 			PianoRequestDataGetPlaylist_t *reqData = req->data;
 			PianoSong_t *playlist = NULL;
+			PianoList_t playlistList;
 
 			assert (req->responseData != NULL);
 			assert (reqData != NULL);
@@ -256,16 +1048,22 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			}
 			assert (items != NULL);
 
+			PianoListInitP (&playlistList, playlist);
 			for (int i = 0; i < json_object_array_length (items); i++) {
 				json_object *s = json_object_array_get_idx (items, i);
 				PianoSong_t *song;
 
-				if ((song = calloc (1, sizeof (*song))) == NULL) {
-					return PIANO_RET_OUT_OF_MEMORY;
+				if ((song = PianoResponseObject (arena,
+						sizeof (*song))) == NULL) {
+					ret = PIANO_RET_OUT_OF_MEMORY;
+					PianoDestroyPlaylist (playlist);
+					goto cleanup;
 				}
+				song->arena = arena;
+				song->fetched = time (NULL);
 
 				if (!json_object_object_get_ex (s, "artistName", NULL)) {
-					free (song);
+					PianoDestroyPlaylist (song);
 					continue;
 				}
 
@@ -290,24 +1088,26 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 								break;
 							}
 						}
-						song->audioUrl = PianoJsonStrdup (qmap, "audioUrl");
+						song->audioUrl = PianoJsonStrdup (arena, qmap,
+								"audioUrl");
 					} else {
 						/* requested quality is not available */
 						ret = PIANO_RET_QUALITY_UNAVAILABLE;
-						free (song);
+						PianoDestroyPlaylist (song);
 						PianoDestroyPlaylist (playlist);
 						goto cleanup;
 					}
 				}
 
 				json_object *v;
-				song->artist = PianoJsonStrdup (s, "artistName");
-				song->album = PianoJsonStrdup (s, "albumName");
-				song->title = PianoJsonStrdup (s, "songName");
-				song->trackToken = PianoJsonStrdup (s, "trackToken");
-				song->stationId = PianoJsonStrdup (s, "stationId");
-				song->coverArt = PianoJsonStrdup (s, "albumArtUrl");
-				song->detailUrl = PianoJsonStrdup (s, "songDetailUrl");
+				song->artist = PianoJsonIntern (s, "artistName");
+				song->album = PianoJsonIntern (s, "albumName");
+				song->title = PianoJsonStrdup (arena, s, "songName");
+				song->trackToken = PianoJsonStrdup (arena, s, "trackToken");
+				song->stationId = PianoJsonIntern (s, "stationId");
+				song->coverArt = PianoJsonIntern (s, "albumArtUrl");
+				song->detailUrl = PianoJsonStrdup (arena, s, "songDetailUrl");
+				song->songIdentity = PianoJsonStrdup (arena, s, "songIdentity");
 				song->fileGain = json_object_object_get_ex (s, "trackGain", &v) ?
 						(float)json_object_get_double (v) : 0.0f;
 				song->length = json_object_object_get_ex (s, "trackLength", &v) ?
@@ -319,7 +1119,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						break;
 				}
 
-				playlist = PianoListAppendP (playlist, song);
+				playlist = PianoListPushP (&playlistList, song);
 			}
 
 			reqData->retPlaylist = playlist;
@@ -358,6 +1158,8 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			assert (station != NULL);
 
 			ph->stations = PianoListDeleteP (ph->stations, station);
+			--ph->stationCount;
+			PianoStationIndexRemove (ph, station);
 			PianoDestroyStation (station);
 			free (station);
 			break;
@@ -377,39 +1179,54 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			/* get artists */
 			json_object *artists;
 			if (json_object_object_get_ex (result, "artists", &artists)) {
+				PianoList_t artistList;
+
+				PianoListInitP (&artistList, searchResult->artists);
 				for (int i = 0; i < json_object_array_length (artists); i++) {
 					json_object *a = json_object_array_get_idx (artists, i);
 					PianoArtist_t *artist;
 
-					if ((artist = calloc (1, sizeof (*artist))) == NULL) {
-						return PIANO_RET_OUT_OF_MEMORY;
+					if ((artist = PianoResponseObject (arena,
+							sizeof (*artist))) == NULL) {
+						ret = PIANO_RET_OUT_OF_MEMORY;
+						PianoDestroySearchResult (searchResult);
+						memset (searchResult, 0, sizeof (*searchResult));
+						goto cleanup;
 					}
+					artist->arena = arena;
 
-					artist->name = PianoJsonStrdup (a, "artistName");
-					artist->musicId = PianoJsonStrdup (a, "musicToken");
+					artist->name = PianoJsonStrdup (arena, a, "artistName");
+					artist->musicId = PianoJsonStrdup (arena, a, "musicToken");
 
-					searchResult->artists =
-							PianoListAppendP (searchResult->artists, artist);
+					searchResult->artists = PianoListPushP (&artistList,
+							artist);
 				}
 			}
 
 			/* get songs */
 			json_object *songs;
 			if (json_object_object_get_ex (result, "songs", &songs)) {
+				PianoList_t songList;
+
+				PianoListInitP (&songList, searchResult->songs);
 				for (int i = 0; i < json_object_array_length (songs); i++) {
 					json_object *s = json_object_array_get_idx (songs, i);
 					PianoSong_t *song;
 
-					if ((song = calloc (1, sizeof (*song))) == NULL) {
-						return PIANO_RET_OUT_OF_MEMORY;
+					if ((song = PianoResponseObject (arena,
+							sizeof (*song))) == NULL) {
+						ret = PIANO_RET_OUT_OF_MEMORY;
+						PianoDestroySearchResult (searchResult);
+						memset (searchResult, 0, sizeof (*searchResult));
+						goto cleanup;
 					}
+					song->arena = arena;
 
-					song->title = PianoJsonStrdup (s, "songName");
-					song->artist = PianoJsonStrdup (s, "artistName");
-					song->musicId = PianoJsonStrdup (s, "musicToken");
+					song->title = PianoJsonStrdup (arena, s, "songName");
+					song->artist = PianoJsonIntern (s, "artistName");
+					song->musicId = PianoJsonStrdup (arena, s, "musicToken");
 
-					searchResult->songs =
-							PianoListAppendP (searchResult->songs, song);
+					searchResult->songs = PianoListPushP (&songList, song);
 				}
 			}
 			break;
@@ -420,19 +1237,24 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			PianoStation_t *tmpStation;
 
 			if ((tmpStation = calloc (1, sizeof (*tmpStation))) == NULL) {
-				return PIANO_RET_OUT_OF_MEMORY;
+				ret = PIANO_RET_OUT_OF_MEMORY;
+				goto cleanup;
 			}
 
 			PianoJsonParseStation (result, tmpStation);
 
-			PianoStation_t *search = PianoFindStationById (ph->stations,
+			PianoStation_t *search = PianoLookupStationById (ph,
 					tmpStation->id);
 			if (search != NULL) {
 				ph->stations = PianoListDeleteP (ph->stations, search);
+				--ph->stationCount;
+				PianoStationIndexRemove (ph, search);
 				PianoDestroyStation (search);
 				free (search);
 			}
 			ph->stations = PianoListAppendP (ph->stations, tmpStation);
+			++ph->stationCount;
+			PianoStationIndexAdd (ph, tmpStation);
 			break;
 		}
 
@@ -456,45 +1278,60 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			/* get genre stations */
 			json_object *categories;
 			if (json_object_object_get_ex (result, "categories", &categories)) {
+				PianoList_t categoryList;
+
+				PianoListInitP (&categoryList, ph->genreStations);
 				for (int i = 0; i < json_object_array_length (categories); i++) {
 					json_object *c = json_object_array_get_idx (categories, i);
 					PianoGenreCategory_t *tmpGenreCategory;
 
-					if ((tmpGenreCategory = calloc (1,
+					if ((tmpGenreCategory = PianoResponseObject (arena,
 							sizeof (*tmpGenreCategory))) == NULL) {
-						return PIANO_RET_OUT_OF_MEMORY;
+						ret = PIANO_RET_OUT_OF_MEMORY;
+						PianoDestroyGenreCategories (ph->genreStations);
+						ph->genreStations = NULL;
+						goto cleanup;
 					}
+					tmpGenreCategory->arena = arena;
 
-					tmpGenreCategory->name = PianoJsonStrdup (c,
+					tmpGenreCategory->name = PianoJsonStrdup (arena, c,
 							"categoryName");
 
 					/* get genre subnodes */
 					json_object *stations;
 					if (json_object_object_get_ex (c, "stations", &stations)) {
+						PianoList_t genreList;
+
+						PianoListInitP (&genreList, tmpGenreCategory->genres);
 						for (int k = 0;
 								k < json_object_array_length (stations); k++) {
 							json_object *s =
 									json_object_array_get_idx (stations, k);
 							PianoGenre_t *tmpGenre;
 
-							if ((tmpGenre = calloc (1,
+							if ((tmpGenre = PianoResponseObject (arena,
 									sizeof (*tmpGenre))) == NULL) {
-								return PIANO_RET_OUT_OF_MEMORY;
+								/* category is not in the list yet */
+								ret = PIANO_RET_OUT_OF_MEMORY;
+								PianoDestroyGenreCategories (tmpGenreCategory);
+								PianoDestroyGenreCategories (ph->genreStations);
+								ph->genreStations = NULL;
+								goto cleanup;
 							}
+							tmpGenre->arena = arena;
 
 							/* get genre attributes */
-							tmpGenre->name = PianoJsonStrdup (s,
+							tmpGenre->name = PianoJsonStrdup (arena, s,
 									"stationName");
-							tmpGenre->musicId = PianoJsonStrdup (s,
+							tmpGenre->musicId = PianoJsonStrdup (arena, s,
 									"stationToken");
 
 							tmpGenreCategory->genres =
-									PianoListAppendP (tmpGenreCategory->genres,
-									tmpGenre);
+									PianoListPushP (&genreList, tmpGenre);
 						}
 					}
 
-					ph->genreStations = PianoListAppendP (ph->genreStations,
+					ph->genreStations = PianoListPushP (&categoryList,
 							tmpGenreCategory);
 				}
 			}
@@ -553,7 +1390,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 
 			settings->explicitContentFilter = getBoolDefault (result,
 					"isExplicitContentFilterEnabled", false);
-			settings->username = PianoJsonStrdup (result, "username");
+			settings->username = PianoJsonStrdup (NULL, result, "username");
 			break;
 		}
 
@@ -573,41 +1410,58 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 				/* songs */
 				json_object *songs;
 				if (json_object_object_get_ex (music, "songs", &songs)) {
+					PianoList_t seedList;
+
+					PianoListInitP (&seedList, info->songSeeds);
 					for (int i = 0; i < json_object_array_length (songs); i++) {
 						json_object *s = json_object_array_get_idx (songs, i);
 						PianoSong_t *seedSong;
 
-						seedSong = calloc (1, sizeof (*seedSong));
+						seedSong = PianoResponseObject (arena,
+								sizeof (*seedSong));
 						if (seedSong == NULL) {
-							return PIANO_RET_OUT_OF_MEMORY;
+							ret = PIANO_RET_OUT_OF_MEMORY;
+							PianoDestroyStationInfo (info);
+							memset (info, 0, sizeof (*info));
+							goto cleanup;
 						}
+						seedSong->arena = arena;
 
-						seedSong->title = PianoJsonStrdup (s, "songName");
-						seedSong->artist = PianoJsonStrdup (s, "artistName");
-						seedSong->seedId = PianoJsonStrdup (s, "seedId");
+						seedSong->title = PianoJsonStrdup (arena, s, "songName");
+						seedSong->artist = PianoJsonIntern (s, "artistName");
+						seedSong->seedId = PianoJsonStrdup (arena, s, "seedId");
 
-						info->songSeeds = PianoListAppendP (info->songSeeds,
-								seedSong);
+						info->songSeeds = PianoListPushP (&seedList, seedSong);
 					}
 				}
 
 				/* artists */
 				json_object *artists;
 				if (json_object_object_get_ex (music, "artists", &artists)) {
+					PianoList_t seedList;
+
+					PianoListInitP (&seedList, info->artistSeeds);
 					for (int i = 0; i < json_object_array_length (artists); i++) {
 						json_object *a = json_object_array_get_idx (artists, i);
 						PianoArtist_t *seedArtist;
 
-						seedArtist = calloc (1, sizeof (*seedArtist));
+						seedArtist = PianoResponseObject (arena,
+								sizeof (*seedArtist));
 						if (seedArtist == NULL) {
-							return PIANO_RET_OUT_OF_MEMORY;
+							ret = PIANO_RET_OUT_OF_MEMORY;
+							PianoDestroyStationInfo (info);
+							memset (info, 0, sizeof (*info));
+							goto cleanup;
 						}
+						seedArtist->arena = arena;
 
-						seedArtist->name = PianoJsonStrdup (a, "artistName");
-						seedArtist->seedId = PianoJsonStrdup (a, "seedId");
+						seedArtist->name = PianoJsonStrdup (arena, a,
+								"artistName");
+						seedArtist->seedId = PianoJsonStrdup (arena, a,
+								"seedId");
 
-						info->artistSeeds =
-								PianoListAppendP (info->artistSeeds, seedArtist);
+						info->artistSeeds = PianoListPushP (&seedList,
+								seedArtist);
 					}
 				}
 			}
@@ -616,6 +1470,9 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			json_object *feedback;
 			if (json_object_object_get_ex (result, "feedback", &feedback)) {
 				static const char * const keys[] = {"thumbsUp", "thumbsDown"};
+				PianoList_t feedbackList;
+
+				PianoListInitP (&feedbackList, info->feedback);
 				for (size_t i = 0; i < sizeof (keys)/sizeof (*keys); i++) {
 					json_object *val;
 					if (!json_object_object_get_ex (feedback, keys[i], &val)) {
@@ -626,15 +1483,20 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						json_object *s = json_object_array_get_idx (val, i);
 						PianoSong_t *feedbackSong;
 
-						feedbackSong = calloc (1, sizeof (*feedbackSong));
+						feedbackSong = PianoResponseObject (arena,
+								sizeof (*feedbackSong));
 						if (feedbackSong == NULL) {
-							return PIANO_RET_OUT_OF_MEMORY;
+							ret = PIANO_RET_OUT_OF_MEMORY;
+							PianoDestroyStationInfo (info);
+							memset (info, 0, sizeof (*info));
+							goto cleanup;
 						}
+						feedbackSong->arena = arena;
 
-						feedbackSong->title = PianoJsonStrdup (s, "songName");
-						feedbackSong->artist = PianoJsonStrdup (s,
-								"artistName");
-						feedbackSong->feedbackId = PianoJsonStrdup (s,
+						feedbackSong->title = PianoJsonStrdup (arena, s,
+								"songName");
+						feedbackSong->artist = PianoJsonIntern (s, "artistName");
+						feedbackSong->feedbackId = PianoJsonStrdup (arena, s,
 								"feedbackId");
 						feedbackSong->rating = getBoolDefault (s, "isPositive",
 								false) ?  PIANO_RATE_LOVE : PIANO_RATE_BAN;
@@ -644,7 +1506,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 								json_object_object_get_ex (s, "trackLength", &v) ?
 								json_object_get_int (v) : 0;
 
-						info->feedback = PianoListAppendP (info->feedback,
+						info->feedback = PianoListPushP (&feedbackList,
 								feedbackSong);
 					}
 				}
@@ -655,6 +1517,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 
 cleanup:
 	json_object_put (j);
+	PianoArenaUnref (arena);
 
 	return ret;
 }
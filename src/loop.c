@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "loop.h"
+
+/*	how long the main loop may sleep if nothing else wakes it up (input,
+ *	hotkeys, background calls)
+ *	@param player is playing
+ *	@param player is paused or there is no station to play
+ *	@param seconds played
+ *	@param song duration in seconds
+ *	@param set if the timeout is the end of the song
+ *	@return milliseconds or BAR_LOOP_INFINITE
+ */
+unsigned long BarLoopTimeout (const bool playing, const bool idle,
+		const double played, const double duration, bool * const songEnd) {
+	assert (songEnd != NULL);
+
+	*songEnd = false;
+	if (playing) {
+		const double remaining = duration - played;
+		/* next full second played, for the time display */
+		unsigned long timeout = 1000 - (unsigned long) (played * 1000) % 1000;
+		if (remaining > 0 && remaining * 1000 < timeout) {
+			/* just after the end */
+			timeout = (unsigned long) (remaining * 1000) + 1;
+			*songEnd = true;
+		}
+		return timeout;
+	} else if (idle) {
+		/* nothing changes by itself */
+		return BAR_LOOP_INFINITE;
+	} else {
+		/* starting playback failed, try again in a second */
+		return 1000;
+	}
+}
+
@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include "main.h"
 #include "console.h"
 #include "hotkey.h"
+#include "loop.h"
 #include "ui.h"
 #include "ui_dispatch.h"
 #include "ui_readline.h"
@@ -166,7 +167,7 @@ static bool BarMainGetStations(BarApp_t *app)
 static void BarMainGetInitialStation (BarApp_t *app) {
 	/* try to get autostart station */
 	if (app->settings.autostartStation != NULL) {
-		app->nextStation = PianoFindStationById (app->ph.stations,
+		app->nextStation = PianoLookupStationById (&app->ph,
 				app->settings.autostartStation);
 		if (app->nextStation == NULL) {
 			BarUiMsg (&app->settings, MSG_ERR,
@@ -212,6 +213,36 @@ static void BarMainHotKeyHandler(int hotKeyId, void *userData)
         BAR_DC_GLOBAL);
 }
 
+/*	sleep until there is something to do: console input, a hotkey, a
+ *	background call being done, the end of the current song or the next
+ *	update of the time display
+ *	@return true if there is console input
+ */
+static bool BarMainWait(BarApp_t *app)
+{
+    HANDLE handles[2];
+    DWORD count = 0, timeout;
+    bool songEnd;
+
+    handles[count++] = BarConsoleGetStdIn();
+    if (app->rpc.ready != NULL)
+        handles[count++] = app->rpc.ready;
+
+    const bool playing = BarPlayer2IsPlaying(app->player);
+    const unsigned long wait = BarLoopTimeout(playing,
+        BarPlayer2IsPaused(app->player) || app->nextStation == NULL,
+        playing ? BarPlayer2GetTime(app->player) : 0.0,
+        playing ? BarPlayer2GetDuration(app->player) : 0.0, &songEnd);
+    timeout = wait == BAR_LOOP_INFINITE ? INFINITE : (DWORD)wait;
+    app->loop.songEnd = songEnd ? GetTickCount() + timeout : 0;
+
+    const DWORD ret = MsgWaitForMultipleObjectsEx(count, handles, timeout,
+        QS_HOTKEY, MWMO_INPUTAVAILABLE);
+    ++app->loop.wakeups;
+
+    return ret == WAIT_OBJECT_0;
+}
+
 /*	wait for user rl
  */
 static void BarMainHandleUserInput(BarApp_t *app)
@@ -219,10 +250,17 @@ static void BarMainHandleUserInput(BarApp_t *app)
     char buf[2];
     size_t readSize = 0;
 
+    if (!BarMainWait(app))
+    {
+        BarHotKeyPool(BarMainHotKeyHandler, app);
+        return;
+    }
+
     BarReadlineSetVirtualKeyHandler(app->rl, BarMainHandleVirtualKey, app);
 
+    /* input is pending, but may not be a key press */
     readSize = BarReadline(buf, sizeof(buf), NULL, app->rl,
-        BAR_RL_FULLRETURN | BAR_RL_NOECHO, 1000);
+        BAR_RL_FULLRETURN | BAR_RL_NOECHO, 0);
 
     BarReadlineSetVirtualKeyHandler(app->rl, NULL, NULL);
 
@@ -240,20 +278,23 @@ static void BarMainHandleUserInput(BarApp_t *app)
 /*	fetch new playlist
  */
 static void BarMainGetPlaylist (BarApp_t *app) {
-	PianoReturn_t pRet;
+	PianoReturn_t pRet = PIANO_RET_OK;
 	PianoRequestDataGetPlaylist_t reqData;
 	reqData.station = app->nextStation;
 	reqData.quality = app->settings.audioQuality;
 
-	BarUiMsg (&app->settings, MSG_INFO, "Receiving new playlist... ");
-	if (!BarUiPianoCall (app, PIANO_REQUEST_GET_PLAYLIST,
-			&reqData, &pRet)) {
-		app->nextStation = NULL;
-	} else {
-		app->playlist = reqData.retPlaylist;
-		if (app->playlist == NULL) {
-			BarUiMsg (&app->settings, MSG_INFO, "No tracks left.\n");
+	/* usually fetched while the last song was playing */
+	if ((app->playlist = BarUiPrefetchTake (app)) == NULL) {
+		BarUiMsg (&app->settings, MSG_INFO, "Receiving new playlist... ");
+		if (!BarUiPianoCall (app, PIANO_REQUEST_GET_PLAYLIST,
+				&reqData, &pRet)) {
 			app->nextStation = NULL;
+		} else {
+			app->playlist = BarUiPlaylistFilter (app, reqData.retPlaylist);
+			if (app->playlist == NULL) {
+				BarUiMsg (&app->settings, MSG_INFO, "No tracks left.\n");
+				app->nextStation = NULL;
+			}
 		}
 	}
 	app->curStation = app->nextStation;
@@ -272,7 +313,7 @@ static void BarMainStartPlayback(BarApp_t *app)
     assert(curSong != NULL);
 
     BarUiPrintSong(&app->settings, curSong, app->curStation->isQuickMix ?
-        PianoFindStationById(app->ph.stations,
+        PianoLookupStationById(&app->ph,
             curSong->stationId) : NULL);
 
     static const char httpPrefix[] = "http://";
@@ -292,10 +333,22 @@ static void BarMainStartPlayback(BarApp_t *app)
             app->curStation, curSong, &app->player, app->ph.stations,
             PIANO_RET_OK);
 
-        if (!BarPlayer2Play(app->player))
-            ++app->retries;
-        else
+        const unsigned long urlAge = (unsigned long)(time(NULL) - curSong->fetched);
+        app->prefetch.lastUrlAge = urlAge;
+        if (urlAge > app->prefetch.maxUrlAge)
+            app->prefetch.maxUrlAge = urlAge;
+
+        if (BarPlayer2Play(app->player))
             app->retries = 0;
+        else if (urlAge >= BAR_AUDIO_URL_FRESH)
+        {
+            /* most likely expired (403), get songs with new urls instead of
+             * counting this as a failure */
+            BarUiMsg(&app->settings, MSG_INFO, "Audio url expired, fetching new songs.\n");
+            BarUiQueueExpireSince(app, curSong);
+        }
+        else
+            ++app->retries;
     }
 }
 
@@ -377,6 +430,17 @@ static void BarMainLoop(BarApp_t *app)
          * song */
         if (BarPlayer2IsFinished(app->player) && app->nextStation != NULL)
         {
+            const DWORD finished = GetTickCount();
+            bool boundary = false;
+
+            if (app->loop.songEnd != 0)
+            {
+                /* woken up by the song end timer */
+                app->loop.lastEndLatency = (long)(finished - app->loop.songEnd) > 0 ?
+                    finished - app->loop.songEnd : 0;
+                app->loop.songEnd = 0;
+            }
+
             /* what's next? */
             if (app->playlist != NULL)
             {
@@ -385,6 +449,8 @@ static void BarMainLoop(BarApp_t *app)
                 histsong->head.next = NULL;
                 BarUiHistoryPrepend(app, histsong);
             }
+            /* audio urls may have expired while paused, for instance */
+            BarUiQueueExpire(app, false);
 			if (app->playlist == NULL && app->nextStation != NULL && !app->doQuit)
 			{
 				if (app->nextStation != app->curStation)
@@ -392,16 +458,25 @@ static void BarMainLoop(BarApp_t *app)
 					BarUiPrintStation (&app->settings, app->nextStation);
 				}
 				BarMainGetPlaylist (app);
+				boundary = true;
 			}
             /* song ready to play */
             if (app->playlist != NULL)
             {
                 BarMainStartPlayback(app);
+                if (boundary)
+                    app->prefetch.lastGap = GetTickCount() - finished;
+
+                /* get the next playlist ready before this one runs dry */
+                BarUiPrefetchPlaylist(app);
             }
         }
 
         BarMainHandleUserInput(app);
 
+        /* finish rpc calls made in the background */
+        BarUiRpcPoll(app);
+
         /* show time */
         if (BarPlayer2IsPlaying(app->player) || BarPlayer2IsPaused(app->player))
         {
@@ -460,22 +535,43 @@ int main(int argc, char **argv)
 
     HttpInit(&app.http2, app.settings.rpcHost, app.settings.rpcTlsPort,
         app.settings.timeout);
+    if (app.settings.caBundle &&
+        !HttpSetCaBundle(app.http2, app.settings.caBundle))
+    {
+        BarUiMsg(&app.settings, MSG_ERR, "%s\n", HttpGetError(app.http2));
+    }
     if (app.settings.controlProxy)
         HttpSetProxy(app.http2, app.settings.controlProxy);
+    if (!BarRecentInit(&app.recent, app.settings.repeatWindow))
+    {
+        BarUiMsg(&app.settings, MSG_ERR, "Cannot allocate repeat filter.\n");
+    }
+    if (!BarUiRpcInit(&app))
+    {
+        BarUiMsg(&app.settings, MSG_ERR, "Cannot start rpc thread.\n");
+    }
 
 
     BarReadlineInit(&app.rl);
 
+    app.loop.started = GetTickCount();
+
     BarMainLoop(&app);
 
+    /* wait for ratings etc. still being sent */
+    BarUiPrefetchDiscard(&app);
+    BarUiRpcDestroy(&app);
+
     BarReadlineDestroy(app.rl);
 
     /* write statefile */
     BarSettingsWrite(app.curStation, &app.settings);
 
+    BarUiDestroyRequests(&app);
     PianoDestroy(&app.ph);
     PianoDestroyPlaylist(app.songHistory);
     PianoDestroyPlaylist(app.playlist);
+    BarRecentDestroy(&app.recent);
     HttpDestroy(app.http2);
     BarPlayer2Destroy(app.player);
     BarSettingsDestroy(&app.settings);
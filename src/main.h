@@ -25,14 +25,116 @@ THE SOFTWARE.
 
 //#include <curl/curl.h>
 
+#include <windows.h>
+
 #include <piano.h>
 
 #include "player/player2.h"
 #include "http/http.h"
 #include "settings.h"
 #include "ui_readline.h"
+#include "recent.h"
+
+/* reauthentication nests one call */
+#define BAR_REQUEST_POOL 2
+
+/* requests reused by BarUiPianoCall */
+typedef struct {
+	PianoRequest_t slots[BAR_REQUEST_POOL];
+	bool used[BAR_REQUEST_POOL];
+	/* rpc calls made and calls that had to (re)allocate request buffers */
+	unsigned long calls, allocs;
+} BarRequestPool_t;
+
+typedef struct BarApp BarApp_t;
+typedef struct BarRpcCall BarRpcCall_t;
+
+/* completion of a background rpc call, run by the main loop */
+typedef void (*BarRpcCallback_t) (BarApp_t *, BarRpcCall_t *);
+
+/* strings etc. freed along with a background call */
+#define BAR_RPC_KEEP 2
+
+/* rpc call made in the background, see BarUiPianoCallAsync */
+struct BarRpcCall {
+	PianoRequestType_t type;
+	/* request data, copied by BarUiRpcNew unless it is a plain pointer */
+	void *data;
+	PianoReturn_t pRet;
+	/* shown with the result, like "Banning song... ", NULL for none */
+	const char *msg;
+	/* called once the call is done, unless it was forgotten */
+	BarRpcCallback_t callback;
+	/* station and song the call refers to, may be NULL. The call is
+	 * forgotten if either is destroyed before it is done. */
+	PianoStation_t *station;
+	PianoSong_t *song;
+
+	PianoRequest_t req;
+	bool ownData, forgotten;
+	void *keep[BAR_RPC_KEEP];
+	int netErrorRetries;
+	/* result of the http request, set by the worker */
+	bool httpOk;
+	char *httpError;
+	/* worker queue and list of all calls not done yet */
+	BarRpcCall_t *next, *nextActive;
+};
 
+/* background rpc calls. The worker thread does the http requests only,
+ * libpiano, retries and callbacks run on the main loop. */
 typedef struct {
+	/* waiting for the worker and done, both in submission order */
+	BarRpcCall_t *pending, *done;
+	/* all calls not done yet, main loop only */
+	BarRpcCall_t *active;
+	HANDLE thread;
+	/* work for the worker, calls done for the main loop */
+	HANDLE wake, ready;
+	CRITICAL_SECTION lock;
+	/* held while http2 is in use, by either thread */
+	CRITICAL_SECTION httpLock;
+	bool quit;
+} BarRpcQueue_t;
+
+/* upper bound for queue_songs/queue_minutes */
+#define BAR_QUEUE_MAX 100
+
+/* audio urls are assumed to be valid this long (seconds) after they were
+ * received, pandora does not say. Songs failing to play with younger urls
+ * are not put down to expiry. */
+#define BAR_AUDIO_URL_LIFETIME (30*60)
+#define BAR_AUDIO_URL_FRESH 60
+
+/* playlists fetched in the background to keep the queue filled */
+typedef struct {
+	/* GET_PLAYLIST call in flight, if any */
+	BarRpcCall_t *call;
+	/* songs that could not be queued yet, valid for station only */
+	PianoSong_t *playlist;
+	PianoStation_t *station;
+	/* background fetches, playlist boundaries served from/without fetched
+	 * songs, gap between the last two songs at the latest boundary in ms */
+	unsigned long fetches, hits, misses, lastGap;
+	/* songs dropped before their audio url expired, songs that failed to
+	 * play with an old url, audio url age at playback start in seconds */
+	unsigned long expired, refetched, lastUrlAge, maxUrlAge;
+	/* songs dropped because they were queued recently */
+	unsigned long repeats;
+} BarPrefetch_t;
+
+/* main loop statistics */
+typedef struct {
+	/* since then */
+	DWORD started;
+	unsigned long wakeups;
+	/* tick the current song is expected to end at, 0 if unknown */
+	DWORD songEnd;
+	/* time between the end of the latest song and noticing it, in ms */
+	unsigned long lastEndLatency;
+} BarLoopStats_t;
+
+struct BarApp {
 	PianoHandle_t ph;
 	//CURL *http;
 	http_t http2;
@@ -47,5 +149,11 @@ typedef struct {
 	char doQuit;
 	BarReadline_t rl;
 	unsigned int retries;
-} BarApp_t;
+	BarRequestPool_t requests;
+	BarRpcQueue_t rpc;
+	BarPrefetch_t prefetch;
+	/* tracks queued recently, see BarUiPlaylistFilter */
+	BarRecent_t recent;
+	BarLoopStats_t loop;
+};
 
@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "recent.h"
+
+/* about 1% false positives per generation */
+#define BAR_RECENT_BITS_PER_ID 10
+#define BAR_RECENT_HASHES 7
+
+/*	fnv-1a, mixed like murmur3’s finalizer. Ids differ in a few trailing
+ *	characters only, which plain fnv spreads badly.
+ */
+static uint64_t BarRecentHash (const char *s) {
+	uint64_t h = UINT64_C(14695981039346656037);
+
+	for (; *s != '\0'; s++) {
+		h ^= (unsigned char) *s;
+		h *= UINT64_C(1099511628211);
+	}
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+	return h;
+}
+
+/*	set or test the bits of id in filter, derived from one hash (double
+ *	hashing)
+ *	@return true if all of them were set already
+ */
+static bool BarRecentBits (const BarRecent_t * const r,
+		unsigned char * const bits, const char * const id, const bool set) {
+	const uint64_t h = BarRecentHash (id);
+	const uint32_t h1 = (uint32_t) h, h2 = (uint32_t) (h >> 32) | 1;
+	const size_t count = r->bytes * 8;
+	bool found = true;
+
+	for (unsigned int i = 0; i < r->hashes; i++) {
+		const size_t bit = (h1 + (uint64_t) i * h2) % count;
+		const unsigned char mask = 1 << (bit % 8);
+		if (!(bits[bit / 8] & mask)) {
+			found = false;
+			if (!set) {
+				break;
+			}
+			bits[bit / 8] |= mask;
+		}
+	}
+	return found;
+}
+
+/*	allocate filter
+ *	@param remember at least this many ids, 0 disables the filter
+ *	@return false if out of memory
+ */
+bool BarRecentInit (BarRecent_t * const r, const unsigned int window) {
+	assert (r != NULL);
+
+	memset (r, 0, sizeof (*r));
+	if (window == 0) {
+		return true;
+	}
+
+	r->window = window;
+	r->hashes = BAR_RECENT_HASHES;
+	r->bytes = ((size_t) window * BAR_RECENT_BITS_PER_ID + 7) / 8;
+	if ((r->bits = calloc (2, r->bytes)) == NULL) {
+		memset (r, 0, sizeof (*r));
+		return false;
+	}
+	return true;
+}
+
+void BarRecentDestroy (BarRecent_t * const r) {
+	free (r->bits);
+	memset (r, 0, sizeof (*r));
+}
+
+/*	@return true if id was added recently, or on a false positive
+ */
+bool BarRecentHas (const BarRecent_t * const r, const char * const id) {
+	assert (r != NULL);
+	assert (id != NULL);
+
+	if (r->window == 0) {
+		return false;
+	}
+	return BarRecentBits (r, r->bits, id, false) ||
+			BarRecentBits (r, r->bits + r->bytes, id, false);
+}
+
+/*	add id, the previous generation is forgotten when the current one is
+ *	full
+ */
+void BarRecentAdd (BarRecent_t * const r, const char * const id) {
+	assert (r != NULL);
+	assert (id != NULL);
+
+	if (r->window == 0) {
+		return;
+	}
+	if (r->count >= r->window) {
+		/* previous generation becomes the current one */
+		r->cur = !r->cur;
+		memset (r->bits + r->cur * r->bytes, 0, r->bytes);
+		r->count = 0;
+	}
+	if (!BarRecentBits (r, r->bits + r->cur * r->bytes, id, true)) {
+		++r->count;
+	}
+}
+
+/*	@return memory used by the filter in bytes
+ */
+size_t BarRecentSize (const BarRecent_t * const r) {
+	return r->bytes * 2;
+}
+
+/*	@return id of the track, identical for every time it is played, or NULL
+ *	for ads etc.
+ */
+static const char *BarRecentSongId (const PianoSong_t * const song) {
+	return song->songIdentity != NULL ? song->songIdentity : song->detailUrl;
+}
+
+/*	drop songs added recently (pandora repeats itself sometimes) from a new
+ *	playlist and add the others. All songs are kept if all of them are
+ *	repeats, that is better than running dry.
+ *	@param filter
+ *	@param new playlist
+ *	@param incremented for every song dropped
+ *	@return filtered playlist
+ */
+PianoSong_t *BarRecentFilter (BarRecent_t * const r, PianoSong_t *playlist,
+		unsigned long * const dropped) {
+	PianoSong_t *song = playlist, **prev = &playlist;
+	bool haveNew = false;
+
+	assert (r != NULL);
+	assert (dropped != NULL);
+
+	PianoListForeachP (song) {
+		const char * const id = BarRecentSongId (song);
+		if (id == NULL || !BarRecentHas (r, id)) {
+			haveNew = true;
+			break;
+		}
+	}
+
+	while (*prev != NULL) {
+		song = *prev;
+		const char * const id = BarRecentSongId (song);
+		if (id == NULL) {
+			prev = (PianoSong_t **) &song->head.next;
+		} else if (haveNew && BarRecentHas (r, id)) {
+			*prev = PianoListNextP (song);
+			song->head.next = NULL;
+			PianoDestroyPlaylist (song);
+			++*dropped;
+		} else {
+			BarRecentAdd (r, id);
+			prev = (PianoSong_t **) &song->head.next;
+		}
+	}
+	return playlist;
+}
+
@@ -0,0 +1,53 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <piano.h>
+
+/* recently queued tracks, a rolling pair of bloom filters. The last window
+ * ids added are always found, older ones are forgotten eventually. Size is
+ * fixed by window. */
+typedef struct {
+	/* two generations of bytes each, current one is cur */
+	unsigned char *bits;
+	size_t bytes;
+	unsigned int cur;
+	/* ids per generation and ids in the current one */
+	unsigned int window, count;
+	/* hash functions */
+	unsigned int hashes;
+} BarRecent_t;
+
+bool BarRecentInit (BarRecent_t *, unsigned int);
+void BarRecentDestroy (BarRecent_t *);
+bool BarRecentHas (const BarRecent_t *, const char *);
+void BarRecentAdd (BarRecent_t *, const char *);
+size_t BarRecentSize (const BarRecent_t *);
+PianoSong_t *BarRecentFilter (BarRecent_t *, PianoSong_t *, unsigned long *);
+
@@ -188,8 +188,12 @@ void BarSettingsRead (BarSettings_t *settings) {
 	settings->history = 5;
 	settings->volume = 0;
 	settings->timeout = 30; /* seconds */
+	settings->queueSongs = 1;
+	settings->queueMinutes = 0;
+	settings->repeatWindow = 100;
 	settings->gainMul = 1.0;
-	/* should be > 4, otherwise expired audio urls (403) can stop playback */
+	/* songs failing with old (expired) audio urls are refetched and do not
+	 * count, see BarMainStartPlayback */
 	settings->maxRetry = 5;
 	settings->sortOrder = BAR_SORT_NAME_AZ;
 	settings->loveIcon = strdup (" <3");
@@ -388,6 +392,12 @@ void BarSettingsRead (BarSettings_t *settings) {
 				settings->history = atoi (val);
 			} else if (streq ("max_retry", key)) {
 				settings->maxRetry = atoi (val);
+			} else if (streq ("queue_songs", key)) {
+				settings->queueSongs = atoi (val);
+			} else if (streq ("queue_minutes", key)) {
+				settings->queueMinutes = atoi (val);
+			} else if (streq ("repeat_window", key)) {
+				settings->repeatWindow = atoi (val);
 			} else if (streq ("timeout", key)) {
 				settings->timeout = atoi (val);
 			} else if (streq ("sort", key)) {
@@ -87,6 +87,11 @@ typedef struct {
 typedef struct {
 	bool autoselect;
 	unsigned int history, maxRetry, timeout;
+	/* upcoming songs to keep queued, at least queueSongs and queueMinutes
+	 * of audio */
+	unsigned int queueSongs, queueMinutes;
+	/* tracks not to queue again until this many others were queued */
+	unsigned int repeatWindow;
 	int volume;
 	float gainMul;
 	BarStationSorting_t sortOrder;
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "console.h"
 #include <assert.h>
 #include <stdio.h>
+#include <process.h>
 
 typedef int (*BarSortFunc_t) (const void *, const void *);
 
@@ -148,46 +149,122 @@ void BarUiMsg (const BarSettings_t *settings, const BarUiMsg_t type,
 	BarConsoleFlush();
 }
 
+/*	get request from the pool, its buffers are reused
+ *	@return request or NULL if out of memory
+ */
+static PianoRequest_t *BarUiRequestGet (BarApp_t * const app) {
+	BarRequestPool_t * const pool = &app->requests;
+
+	for (size_t i = 0; i < BAR_REQUEST_POOL; i++) {
+		if (!pool->used[i]) {
+			pool->used[i] = true;
+			return &pool->slots[i];
+		}
+	}
+
+	/* nested deeper than expected, use a one-off request */
+	return calloc (1, sizeof (PianoRequest_t));
+}
+
+/*	return request to the pool
+ */
+static void BarUiRequestPut (BarApp_t * const app, PianoRequest_t * const req) {
+	BarRequestPool_t * const pool = &app->requests;
+
+	for (size_t i = 0; i < BAR_REQUEST_POOL; i++) {
+		if (req == &pool->slots[i]) {
+			PianoResetRequest (req);
+			pool->used[i] = false;
+			return;
+		}
+	}
+
+	free (req->responseData);
+	PianoDestroyRequest (req);
+	free (req);
+}
+
+/*	free buffers of all pooled requests
+ */
+void BarUiDestroyRequests (BarApp_t * const app) {
+	BarRequestPool_t * const pool = &app->requests;
+
+	for (size_t i = 0; i < BAR_REQUEST_POOL; i++) {
+		assert (!pool->used[i]);
+		free (pool->slots[i].responseData);
+		PianoDestroyRequest (&pool->slots[i]);
+	}
+}
+
+/*	libpiano receive callback, gets the next piece of the response body
+ */
+static PianoReturn_t BarUiReceive (PianoRequest_t *req) {
+	BarApp_t * const app = req->receiveData;
+	bool done;
+
+	if (!HttpRequestReceive (app->http2, req, &done)) {
+		return PIANO_RET_NETWORK_ERROR;
+	}
+	return done ? PIANO_RET_OK : PIANO_RET_CONTINUE_REQUEST;
+}
+
 /*	piano wrapper: prepare/execute http request and pass result back to
  *	libpiano (updates data structures)
  *	@return 1 on success, 0 otherwise
  */
 int BarUiPianoCall (BarApp_t * const app, PianoRequestType_t type,
 		void *data, PianoReturn_t *pRet) {
-	PianoRequest_t req;
+	PianoRequest_t * const req = BarUiRequestGet (app);
 	int netErrorRetries = 3;
 
-	memset (&req, 0, sizeof (req));
+	if (req == NULL) {
+		*pRet = PIANO_RET_OUT_OF_MEMORY;
+		BarUiMsg (&app->settings, MSG_NONE, "Error: %s\n", PianoErrorToStr (*pRet));
+		return 0;
+	}
+
+	const size_t postDataCapacity = req->postDataCapacity,
+			responseDataCapacity = req->responseDataCapacity;
+	int ret = 0;
 
 	/* repeat as long as there are http requests to do */
 	do {
-		req.data = data;
+		req->data = data;
 
-		*pRet = PianoRequest (&app->ph, &req, type);
+		*pRet = PianoRequest (&app->ph, req, type);
 		if (*pRet != PIANO_RET_OK) {
 			BarUiMsg (&app->settings, MSG_NONE, "Error: %s\n", PianoErrorToStr (*pRet));
-			PianoDestroyRequest (&req);
-			return 0;
+			goto done;
 		}
 
-		if (!HttpRequest(app->http2, &req)) {
+		/* the response is parsed while it is received, background calls
+		 * wait meanwhile */
+		EnterCriticalSection (&app->rpc.httpLock);
+		if (HttpRequestBegin (app->http2, req)) {
+			req->receive = BarUiReceive;
+			req->receiveData = app;
+			*pRet = PianoResponse (&app->ph, req);
+			req->receive = NULL;
+		} else {
 			*pRet = PIANO_RET_NETWORK_ERROR;
+		}
+
+		if (*pRet == PIANO_RET_NETWORK_ERROR) {
 			BarUiMsg(&app->settings, MSG_ERR, "Network error: %s\n",
 				HttpGetError(app->http2));
-			if (req.responseData != NULL) {
-				free(req.responseData);
-			}
+		}
+		LeaveCriticalSection (&app->rpc.httpLock);
+
+		if (*pRet == PIANO_RET_NETWORK_ERROR) {
 			if (--netErrorRetries > 0) {
 				/* try again */
 				*pRet = PIANO_RET_CONTINUE_REQUEST;
 				BarUiMsg (&app->settings, MSG_INFO, "Trying again... ");
 				continue;
 			}
-			PianoDestroyRequest(&req);
-			return 0;
+			goto done;
 		}
 
-		*pRet = PianoResponse (&app->ph, &req);
 		if (*pRet != PIANO_RET_CONTINUE_REQUEST) {
 			/* checking for request type avoids infinite loops */
 			if (*pRet == PIANO_RET_P_INVALID_AUTH_TOKEN &&
@@ -202,11 +279,7 @@ int BarUiPianoCall (BarApp_t * const app, PianoRequestType_t type,
 				BarUiMsg (&app->settings, MSG_NONE, "Reauthentication required... ");
 				if (!BarUiPianoCall (app, PIANO_REQUEST_LOGIN, &reqData, &authpRet)) {
 					*pRet = authpRet;
-					if (req.responseData != NULL) {
-						free (req.responseData);
-					}
-					PianoDestroyRequest (&req);
-					return 0;
+					goto done;
 				} else {
 					/* try again */
 					*pRet = PIANO_RET_CONTINUE_REQUEST;
@@ -214,25 +287,612 @@ int BarUiPianoCall (BarApp_t * const app, PianoRequestType_t type,
 				}
 			} else if (*pRet != PIANO_RET_OK) {
 				BarUiMsg (&app->settings, MSG_NONE, "Error: %s\n", PianoErrorToStr (*pRet));
-				if (req.responseData != NULL) {
-					free (req.responseData);
-				}
-				PianoDestroyRequest (&req);
-				return 0;
+				goto done;
 			} else {
 				BarUiMsg (&app->settings, MSG_NONE, "Ok.\n");
 			}
 		}
-		/* we can destroy the request at this point, even when this call needs
-		 * more than one http request. persistent data (step counter, e.g.) is
-		 * stored in req.data */
-		if (req.responseData != NULL) {
-			free (req.responseData);
-		}
-		PianoDestroyRequest (&req);
+		/* the request’s buffers are simply overwritten, even when this call
+		 * needs more than one http request. persistent data (step counter,
+		 * e.g.) is stored in req->data */
 	} while (*pRet == PIANO_RET_CONTINUE_REQUEST);
 
-	return 1;
+	ret = 1;
+
+done:
+	++app->requests.calls;
+	if (req->postDataCapacity != postDataCapacity ||
+			req->responseDataCapacity != responseDataCapacity) {
+		++app->requests.allocs;
+	}
+	BarUiRequestPut (app, req);
+
+	return ret;
+}
+
+/*	worker thread, runs the http requests of background calls one after
+ *	another
+ */
+static unsigned __stdcall BarUiRpcThread (void *data) {
+	BarApp_t * const app = data;
+	BarRpcQueue_t * const rpc = &app->rpc;
+
+	while (true) {
+		EnterCriticalSection (&rpc->lock);
+		BarRpcCall_t * const call = rpc->pending;
+		if (call != NULL) {
+			rpc->pending = call->next;
+			call->next = NULL;
+		}
+		const bool quit = rpc->quit;
+		LeaveCriticalSection (&rpc->lock);
+
+		if (call == NULL) {
+			if (quit) {
+				break;
+			}
+			WaitForSingleObject (rpc->wake, INFINITE);
+			continue;
+		}
+
+		EnterCriticalSection (&rpc->httpLock);
+		call->httpOk = HttpRequest (app->http2, &call->req);
+		if (!call->httpOk) {
+			const char * const error = HttpGetError (app->http2);
+			call->httpError = strdup (error != NULL ? error : "unknown");
+		}
+		LeaveCriticalSection (&rpc->httpLock);
+
+		EnterCriticalSection (&rpc->lock);
+		BarRpcCall_t **last = &rpc->done;
+		while (*last != NULL) {
+			last = &(*last)->next;
+		}
+		*last = call;
+		LeaveCriticalSection (&rpc->lock);
+		SetEvent (rpc->ready);
+	}
+
+	return 0;
+}
+
+/*	start worker thread
+ *	@return false if that failed, background calls are not possible then
+ */
+bool BarUiRpcInit (BarApp_t * const app) {
+	BarRpcQueue_t * const rpc = &app->rpc;
+
+	InitializeCriticalSection (&rpc->lock);
+	InitializeCriticalSection (&rpc->httpLock);
+	rpc->wake = CreateEvent (NULL, FALSE, FALSE, NULL);
+	rpc->ready = CreateEvent (NULL, FALSE, FALSE, NULL);
+	if (rpc->wake == NULL || rpc->ready == NULL) {
+		return false;
+	}
+	rpc->thread = (HANDLE) _beginthreadex (NULL, 0, BarUiRpcThread, app, 0,
+			NULL);
+	return rpc->thread != NULL;
+}
+
+/*	create background call
+ *	@param request type
+ *	@param request data, copied if size is not 0
+ *	@param size of request data
+ *	@return call, to be passed to BarUiPianoCallAsync, or NULL
+ */
+BarRpcCall_t *BarUiRpcNew (PianoRequestType_t type, void *data,
+		const size_t size) {
+	BarRpcCall_t * const call = calloc (1, sizeof (*call));
+
+	if (call == NULL) {
+		return NULL;
+	}
+	call->type = type;
+	call->msg = "";
+	call->netErrorRetries = 3;
+	if (size > 0) {
+		if ((call->data = malloc (size)) == NULL) {
+			free (call);
+			return NULL;
+		}
+		memcpy (call->data, data, size);
+		call->ownData = true;
+	} else {
+		call->data = data;
+	}
+	return call;
+}
+
+/*	free ptr along with the call, for request data that has to live as long
+ *	@return ptr
+ */
+void *BarUiRpcKeep (BarRpcCall_t * const call, void * const ptr) {
+	for (size_t i = 0; i < BAR_RPC_KEEP; i++) {
+		if (call->keep[i] == NULL) {
+			call->keep[i] = ptr;
+			return ptr;
+		}
+	}
+	assert (0);
+	return ptr;
+}
+
+static void BarUiRpcFree (BarRpcCall_t * const call) {
+	for (size_t i = 0; i < BAR_RPC_KEEP; i++) {
+		free (call->keep[i]);
+	}
+	if (call->ownData) {
+		free (call->data);
+	}
+	free (call->httpError);
+	free (call->req.responseData);
+	PianoDestroyRequest (&call->req);
+	free (call);
+}
+
+/*	remove call from the list of active calls and finish it
+ */
+static void BarUiRpcDone (BarApp_t * const app, BarRpcCall_t * const call) {
+	BarRpcCall_t **prev = &app->rpc.active;
+
+	while (*prev != call) {
+		prev = &(*prev)->nextActive;
+	}
+	*prev = call->nextActive;
+
+	if (!call->forgotten) {
+		if (call->msg == NULL) {
+			/* quiet */
+		} else if (call->pRet == PIANO_RET_OK) {
+			BarUiMsg (&app->settings, MSG_INFO, "%sOk.\n", call->msg);
+		} else {
+			BarUiMsg (&app->settings, MSG_ERR, "%sError: %s\n", call->msg,
+					PianoErrorToStr (call->pRet));
+		}
+		if (call->callback != NULL) {
+			call->callback (app, call);
+		}
+	}
+	BarUiRpcFree (call);
+}
+
+/*	build request and hand it to the worker
+ */
+static void BarUiRpcStart (BarApp_t * const app, BarRpcCall_t * const call) {
+	BarRpcQueue_t * const rpc = &app->rpc;
+
+	call->req.data = call->data;
+	if ((call->pRet = PianoRequest (&app->ph, &call->req, call->type)) !=
+			PIANO_RET_OK) {
+		BarUiRpcDone (app, call);
+		return;
+	}
+
+	free (call->httpError);
+	call->httpError = NULL;
+
+	EnterCriticalSection (&rpc->lock);
+	BarRpcCall_t **last = &rpc->pending;
+	while (*last != NULL) {
+		last = &(*last)->next;
+	}
+	*last = call;
+	LeaveCriticalSection (&rpc->lock);
+	SetEvent (rpc->wake);
+}
+
+/*	make rpc call in the background, the main loop calls call->callback once
+ *	it is done. Like BarUiPianoCall, but the response is handled by
+ *	BarUiRpcPoll.
+ *	@param call from BarUiRpcNew
+ */
+void BarUiPianoCallAsync (BarApp_t * const app, BarRpcCall_t * const call) {
+	assert (call != NULL);
+
+	if (app->rpc.thread == NULL) {
+		/* no worker, block instead */
+		if (call->msg != NULL) {
+			BarUiMsg (&app->settings, MSG_INFO, "%s", call->msg);
+		}
+		BarUiPianoCall (app, call->type, call->data, &call->pRet);
+		if (call->callback != NULL) {
+			call->callback (app, call);
+		}
+		BarUiRpcFree (call);
+		return;
+	}
+
+	call->nextActive = app->rpc.active;
+	app->rpc.active = call;
+	++app->requests.calls;
+	BarUiRpcStart (app, call);
+}
+
+/*	handle the response of a call the worker is done with
+ */
+static void BarUiRpcResponse (BarApp_t * const app, BarRpcCall_t * const call) {
+	if (call->forgotten) {
+		/* whatever the response says, there is nothing left to update */
+		BarUiRpcDone (app, call);
+		return;
+	}
+
+	if (!call->httpOk) {
+		if (call->msg != NULL) {
+			BarUiMsg (&app->settings, MSG_ERR, "Network error: %s\n",
+					call->httpError);
+		}
+		if (--call->netErrorRetries > 0) {
+			if (call->msg != NULL) {
+				BarUiMsg (&app->settings, MSG_INFO, "%sTrying again...\n",
+						call->msg);
+			}
+			BarUiRpcStart (app, call);
+		} else {
+			call->pRet = PIANO_RET_NETWORK_ERROR;
+			BarUiRpcDone (app, call);
+		}
+		return;
+	}
+
+	call->pRet = PianoResponse (&app->ph, &call->req);
+	if (call->pRet == PIANO_RET_CONTINUE_REQUEST) {
+		BarUiRpcStart (app, call);
+	} else if (call->pRet == PIANO_RET_P_INVALID_AUTH_TOKEN &&
+			call->type != PIANO_REQUEST_LOGIN) {
+		/* reauthenticate */
+		PianoReturn_t authpRet;
+		PianoRequestDataLogin_t reqData;
+		reqData.user = app->settings.username;
+		reqData.password = app->settings.password;
+		reqData.step = 0;
+
+		BarUiMsg (&app->settings, MSG_NONE, "Reauthentication required... ");
+		if (BarUiPianoCall (app, PIANO_REQUEST_LOGIN, &reqData, &authpRet)) {
+			BarUiRpcStart (app, call);
+		} else {
+			call->pRet = authpRet;
+			BarUiRpcDone (app, call);
+		}
+	} else {
+		BarUiRpcDone (app, call);
+	}
+}
+
+/*	handle background calls the worker is done with, called by the main
+ *	loop only
+ */
+void BarUiRpcPoll (BarApp_t * const app) {
+	BarRpcQueue_t * const rpc = &app->rpc;
+
+	EnterCriticalSection (&rpc->lock);
+	BarRpcCall_t *call = rpc->done;
+	rpc->done = NULL;
+	LeaveCriticalSection (&rpc->lock);
+
+	while (call != NULL) {
+		BarRpcCall_t * const next = call->next;
+		call->next = NULL;
+		BarUiRpcResponse (app, call);
+		call = next;
+	}
+}
+
+/*	song or station is going to be destroyed, forget calls referring to it
+ */
+void BarUiRpcForget (BarApp_t * const app, const void * const ptr) {
+	assert (ptr != NULL);
+
+	for (BarRpcCall_t *call = app->rpc.active; call != NULL;
+			call = call->nextActive) {
+		if ((const void *) call->station == ptr ||
+				(const void *) call->song == ptr ||
+				(!call->ownData && call->data == ptr)) {
+			call->forgotten = true;
+			if (call == app->prefetch.call) {
+				app->prefetch.call = NULL;
+			}
+		}
+	}
+}
+
+/*	destroy playlist, forgetting background calls for its songs
+ */
+void BarUiDestroyPlaylist (BarApp_t * const app, PianoSong_t *playlist) {
+	PianoSong_t *song = playlist;
+
+	PianoListForeachP (song) {
+		BarUiRpcForget (app, song);
+	}
+	PianoDestroyPlaylist (playlist);
+}
+
+/*	append songs to playlist
+ *	@return new playlist head
+ */
+static PianoSong_t *BarUiPlaylistJoin (PianoSong_t *playlist,
+		PianoSong_t *songs) {
+	while (songs != NULL) {
+		PianoSong_t * const next = PianoListNextP (songs);
+		songs->head.next = NULL;
+		playlist = PianoListAppendP (playlist, songs);
+		songs = next;
+	}
+	return playlist;
+}
+
+/*	count songs queued after the current one for app->nextStation
+ *	@param returns number of songs
+ *	@param returns their length in seconds
+ */
+void BarUiQueueDepth (const BarApp_t * const app, unsigned int *songs,
+		unsigned int *seconds) {
+	const BarPrefetch_t * const prefetch = &app->prefetch;
+	const PianoSong_t *song;
+
+	*songs = 0;
+	*seconds = 0;
+	if (app->nextStation == NULL) {
+		return;
+	}
+	if (app->curStation == app->nextStation && app->playlist != NULL) {
+		song = PianoListNextP (app->playlist);
+		PianoListForeachP (song) {
+			++*songs;
+			*seconds += song->length;
+		}
+	}
+	if (prefetch->station == app->nextStation) {
+		song = prefetch->playlist;
+		PianoListForeachP (song) {
+			++*songs;
+			*seconds += song->length;
+		}
+	}
+}
+
+/*	drop songs from list whose audio url expires before they get played
+ *	@param list head, updated
+ *	@param expected playback start of the first song, updated
+ *	@return number of songs dropped
+ */
+static unsigned int BarUiPlaylistExpire (BarApp_t * const app,
+		PianoSong_t ** const list, time_t * const start) {
+	PianoSong_t **prev = list;
+	unsigned int dropped = 0;
+
+	while (*prev != NULL) {
+		PianoSong_t * const song = *prev;
+		if (song->fetched + BAR_AUDIO_URL_LIFETIME <= *start) {
+			*prev = PianoListNextP (song);
+			song->head.next = NULL;
+			BarUiDestroyPlaylist (app, song);
+			++dropped;
+		} else {
+			*start += song->length;
+			prev = (PianoSong_t **) &song->head.next;
+		}
+	}
+	return dropped;
+}
+
+/*	drop queued songs that would play with an expired audio url, the current
+ *	song is included unless it is playing already. Background fetches top up
+ *	the queue again.
+ *	@param started current song was started already, keep it even if it
+ *		failed to play (BarUiQueueExpireSince took care of that)
+ */
+void BarUiQueueExpire (BarApp_t * const app, const bool started) {
+	BarPrefetch_t * const prefetch = &app->prefetch;
+	time_t start = time (NULL);
+	unsigned int dropped = 0;
+
+	if (app->playlist == NULL) {
+		/* nothing queued */
+	} else if (BarPlayer2IsPlaying (app->player) ||
+			BarPlayer2IsPaused (app->player) || started) {
+		const double remaining = BarPlayer2GetDuration (app->player) -
+				BarPlayer2GetTime (app->player);
+		if (remaining > 0) {
+			start += (time_t) remaining;
+		}
+		dropped += BarUiPlaylistExpire (app,
+				(PianoSong_t **) &app->playlist->head.next, &start);
+	} else {
+		dropped += BarUiPlaylistExpire (app, &app->playlist, &start);
+	}
+	if (prefetch->playlist != NULL) {
+		dropped += BarUiPlaylistExpire (app, &prefetch->playlist, &start);
+	}
+
+	if (dropped > 0) {
+		prefetch->expired += dropped;
+		BarUiMsg (&app->settings, MSG_INFO, "Dropped %u queued songs, "
+				"audio url expired.\n", dropped);
+	}
+}
+
+/*	drop queued songs received no later than song, it failed to play and its
+ *	audio url is most likely expired
+ */
+void BarUiQueueExpireSince (BarApp_t * const app,
+		const PianoSong_t * const song) {
+	assert (song == app->playlist);
+
+	BarPrefetch_t * const prefetch = &app->prefetch;
+	PianoSong_t ** const lists[] = {
+			(PianoSong_t **) &app->playlist->head.next, &prefetch->playlist};
+	const time_t fetched = song->fetched;
+
+	for (size_t i = 0; i < sizeof (lists) / sizeof (*lists); i++) {
+		PianoSong_t **prev = lists[i];
+		while (*prev != NULL) {
+			PianoSong_t * const s = *prev;
+			if (s->fetched <= fetched) {
+				*prev = PianoListNextP (s);
+				s->head.next = NULL;
+				BarUiDestroyPlaylist (app, s);
+				++prefetch->expired;
+			} else {
+				prev = (PianoSong_t **) &s->head.next;
+			}
+		}
+	}
+	++prefetch->refetched;
+}
+
+/*	drop songs queued recently from a new playlist, see BarRecentFilter
+ *	@return filtered playlist
+ */
+PianoSong_t *BarUiPlaylistFilter (BarApp_t * const app,
+		PianoSong_t *playlist) {
+	return BarRecentFilter (&app->recent, playlist, &app->prefetch.repeats);
+}
+
+static void BarUiPrefetchDone (BarApp_t *app, BarRpcCall_t *call) {
+	PianoRequestDataGetPlaylist_t * const reqData = call->data;
+	BarPrefetch_t * const prefetch = &app->prefetch;
+
+	assert (call == prefetch->call);
+
+	prefetch->call = NULL;
+	if (call->pRet != PIANO_RET_OK || reqData->retPlaylist == NULL) {
+		/* try again once the next song starts */
+		return;
+	}
+	if (reqData->station != app->nextStation) {
+		/* playback stopped or station changed meanwhile */
+		PianoDestroyPlaylist (reqData->retPlaylist);
+		reqData->retPlaylist = NULL;
+		return;
+	}
+	reqData->retPlaylist = BarUiPlaylistFilter (app, reqData->retPlaylist);
+	if (app->playlist != NULL && app->curStation == reqData->station &&
+			prefetch->playlist == NULL) {
+		/* same station, queue right away */
+		BarUiPlaylistJoin (app->playlist, reqData->retPlaylist);
+	} else {
+		/* still playing another station’s song, or nothing at all */
+		prefetch->playlist = BarUiPlaylistJoin (prefetch->playlist,
+				reqData->retPlaylist);
+		prefetch->station = reqData->station;
+	}
+	reqData->retPlaylist = NULL;
+
+	/* top up */
+	BarUiPrefetchPlaylist (app);
+}
+
+/*	fetch another playlist for app->nextStation in the background, if fewer
+ *	songs than configured (queue_songs, queue_minutes) are queued after the
+ *	current one
+ */
+void BarUiPrefetchPlaylist (BarApp_t * const app) {
+	BarPrefetch_t * const prefetch = &app->prefetch;
+	unsigned int songs, seconds;
+
+	if (app->rpc.thread == NULL || app->nextStation == NULL ||
+			app->playlist == NULL || prefetch->call != NULL) {
+		return;
+	}
+	/* the current song was started already */
+	BarUiQueueExpire (app, true);
+	BarUiQueueDepth (app, &songs, &seconds);
+	if (songs >= BAR_QUEUE_MAX || (songs >= app->settings.queueSongs &&
+			seconds >= app->settings.queueMinutes * 60)) {
+		return;
+	}
+
+	PianoRequestDataGetPlaylist_t reqData;
+	memset (&reqData, 0, sizeof (reqData));
+	reqData.station = app->nextStation;
+	reqData.quality = app->settings.audioQuality;
+
+	BarRpcCall_t * const call = BarUiRpcNew (PIANO_REQUEST_GET_PLAYLIST,
+			&reqData, sizeof (reqData));
+	if (call == NULL) {
+		return;
+	}
+	/* errors show up when the playlist is fetched the usual way */
+	call->msg = NULL;
+	call->netErrorRetries = 1;
+	call->station = app->nextStation;
+	call->callback = BarUiPrefetchDone;
+	prefetch->call = call;
+	++prefetch->fetches;
+	BarUiPianoCallAsync (app, call);
+}
+
+/*	drop prefetched playlist, next station changed
+ */
+void BarUiPrefetchDiscard (BarApp_t * const app) {
+	BarPrefetch_t * const prefetch = &app->prefetch;
+
+	if (prefetch->call != NULL) {
+		prefetch->call->forgotten = true;
+		prefetch->call = NULL;
+	}
+	PianoDestroyPlaylist (prefetch->playlist);
+	prefetch->playlist = NULL;
+	prefetch->station = NULL;
+}
+
+/*	take prefetched playlist for app->nextStation, waits for it if it is
+ *	still being fetched
+ *	@return playlist or NULL, if it has to be fetched now
+ */
+PianoSong_t *BarUiPrefetchTake (BarApp_t * const app) {
+	BarPrefetch_t * const prefetch = &app->prefetch;
+
+	BarUiRpcPoll (app);
+	while (prefetch->playlist == NULL && prefetch->call != NULL &&
+			prefetch->call->station == app->nextStation) {
+		WaitForSingleObject (app->rpc.ready, INFINITE);
+		BarUiRpcPoll (app);
+	}
+
+	PianoSong_t * const playlist = prefetch->playlist;
+	if (playlist == NULL || prefetch->station != app->nextStation) {
+		BarUiPrefetchDiscard (app);
+		++prefetch->misses;
+		return NULL;
+	}
+	prefetch->playlist = NULL;
+	prefetch->station = NULL;
+	++prefetch->hits;
+	return playlist;
+}
+
+/*	finish outstanding background calls and stop the worker
+ */
+void BarUiRpcDestroy (BarApp_t * const app) {
+	BarRpcQueue_t * const rpc = &app->rpc;
+
+	if (rpc->thread != NULL) {
+		/* the main loop may have consumed ready without polling, calls
+		 * done by then would never signal it again */
+		BarUiRpcPoll (app);
+		while (rpc->active != NULL) {
+			WaitForSingleObject (rpc->ready, INFINITE);
+			BarUiRpcPoll (app);
+		}
+
+		EnterCriticalSection (&rpc->lock);
+		rpc->quit = true;
+		LeaveCriticalSection (&rpc->lock);
+		SetEvent (rpc->wake);
+		WaitForSingleObject (rpc->thread, INFINITE);
+		CloseHandle (rpc->thread);
+		rpc->thread = NULL;
+	}
+	if (rpc->wake != NULL) {
+		CloseHandle (rpc->wake);
+	}
+	if (rpc->ready != NULL) {
+		CloseHandle (rpc->ready);
+	}
+	DeleteCriticalSection (&rpc->lock);
+	DeleteCriticalSection (&rpc->httpLock);
 }
 
 /*	Station sorting functions */
@@ -291,10 +951,11 @@ static int BarStationCmpQuickmix10NameZA (const void *a, const void *b) {
 
 /*	sort linked list (station)
  *	@param stations
- *	@return NULL-terminated array with sorted stations
+ *	@param length of stations
+ *	@return array with sorted stations
  */
 static PianoStation_t **BarSortedStations (PianoStation_t *unsortedStations,
-		size_t *retStationCount, BarStationSorting_t order) {
+		const size_t stationCount, BarStationSorting_t order) {
 	static const BarSortFunc_t orderMapping[] = {BarStationNameAZCmp,
 			BarStationNameZACmp,
 			BarStationCmpQuickmix01NameAZ,
@@ -303,24 +964,24 @@ static PianoStation_t **BarSortedStations (PianoStation_t *unsortedStations,
 			BarStationCmpQuickmix10NameZA,
 			};
 	PianoStation_t **stationArray = NULL, *currStation = NULL;
-	size_t stationCount = 0, i;
+	size_t i;
 
 	assert (order < sizeof (orderMapping)/sizeof(*orderMapping));
 
-	stationCount = PianoListCountP (unsortedStations);
 	stationArray = calloc (stationCount, sizeof (*stationArray));
 
 	/* copy station pointers */
 	i = 0;
 	currStation = unsortedStations;
-	PianoListForeachP (currStation) {
+	while (currStation != NULL && i < stationCount) {
 		stationArray[i] = currStation;
+		currStation = PianoListNextP (currStation);
 		++i;
 	}
+	assert (i == stationCount && currStation == NULL);
 
 	qsort (stationArray, stationCount, sizeof (*stationArray), orderMapping[order]);
 
-	*retStationCount = stationCount;
 	return stationArray;
 }
 
@@ -346,8 +1007,10 @@ PianoStation_t *BarUiSelectStation (BarApp_t *app, PianoStation_t *stations,
 
 	memset (buf, 0, sizeof (buf));
 
-	/* sort and print stations */
-	sortedStations = BarSortedStations (stations, &stationCount,
+	/* sort and print stations, the handle keeps track of its own */
+	stationCount = stations == app->ph.stations ? app->ph.stationCount :
+			PianoListCountP (stations);
+	sortedStations = BarSortedStations (stations, stationCount,
 			app->settings.sortOrder);
 
 	do {
@@ -683,7 +1346,7 @@ size_t BarUiListSongs (const BarApp_t * const app,
 			const char *stationName = empty;
 
 			const PianoStation_t * const station =
-					PianoFindStationById (app->ph.stations, song->stationId);
+					PianoLookupStationById (&app->ph, song->stationId);
 			if (station != NULL && station != app->curStation) {
 				stationName = station->name;
 			} else if (station == NULL && song->stationId != NULL) {
@@ -841,13 +1504,13 @@ void BarUiHistoryPrepend (BarApp_t *app, PianoSong_t *song) {
 			del = PianoListGetP (app->songHistory, app->settings.history);
 			if (del != NULL) {
 				app->songHistory = PianoListDeleteP (app->songHistory, del);
-				PianoDestroyPlaylist (del);
+				BarUiDestroyPlaylist (app, del);
 			} else {
 				break;
 			}
 		} while (true);
 	} else {
-		PianoDestroyPlaylist (song);
+		BarUiDestroyPlaylist (app, song);
 	}
 }
 
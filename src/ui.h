@@ -52,5 +52,22 @@ void BarUiStartEventCmd (const BarSettings_t *, const char *,
 		PianoStation_t *, PianoReturn_t);
 int BarUiPianoCall (BarApp_t * const, PianoRequestType_t,
 		void *, PianoReturn_t *);
+void BarUiDestroyRequests (BarApp_t * const);
+bool BarUiRpcInit (BarApp_t * const);
+void BarUiRpcDestroy (BarApp_t * const);
+BarRpcCall_t *BarUiRpcNew (PianoRequestType_t, void *, const size_t);
+void *BarUiRpcKeep (BarRpcCall_t * const, void * const);
+void BarUiPianoCallAsync (BarApp_t * const, BarRpcCall_t * const);
+void BarUiRpcPoll (BarApp_t * const);
+void BarUiRpcForget (BarApp_t * const, const void * const);
+void BarUiDestroyPlaylist (BarApp_t * const, PianoSong_t *);
+void BarUiQueueDepth (const BarApp_t * const, unsigned int *,
+		unsigned int *);
+void BarUiQueueExpire (BarApp_t * const, const bool);
+void BarUiQueueExpireSince (BarApp_t * const, const PianoSong_t * const);
+PianoSong_t *BarUiPlaylistFilter (BarApp_t * const, PianoSong_t *);
+void BarUiPrefetchPlaylist (BarApp_t * const);
+void BarUiPrefetchDiscard (BarApp_t * const);
+PianoSong_t *BarUiPrefetchTake (BarApp_t * const);
 void BarUiHistoryPrepend (BarApp_t *app, PianoSong_t *song);
 
@@ -45,6 +45,22 @@ THE SOFTWARE.
 #define BarUiActDefaultPianoCall(call, arg) BarUiPianoCall (app, \
 		call, arg, &pRet)
 
+/*	standard background piano call, selStation and selSong are passed on to
+ *	the callback
+ */
+#define BarUiActDefaultPianoCallAsync(call) do { \
+		(call)->station = selStation; \
+		(call)->song = selSong; \
+		BarUiPianoCallAsync (app, call); \
+	} while (0)
+
+/*	variables used by BarUiActDefaultEventcmd in background call callbacks
+ */
+#define BarUiActDoneVars(call) \
+		PianoStation_t * const selStation = (call)->station; \
+		PianoSong_t * const selSong = (call)->song; \
+		const PianoReturn_t pRet = (call)->pRet
+
 /*	helper to _really_ skip a song (unlock mutex, quit player)
  *	@param player handle
  */
@@ -89,10 +105,15 @@ BarUiActCallback(BarUiActHelp) {
 	}
 }
 
+static void BarUiActAddMusicDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("stationaddmusic");
+}
+
 /*	add more music to current station
  */
 BarUiActCallback(BarUiActAddMusic) {
-	PianoReturn_t pRet;
 	PianoRequestDataAddSeed_t reqData;
 
 	assert (selStation != NULL);
@@ -100,31 +121,42 @@ BarUiActCallback(BarUiActAddMusic) {
 	reqData.musicId = BarUiSelectMusicId (app, selStation,
 			"Add artist or title to station: ");
 	if (reqData.musicId != NULL) {
-		if (!BarTransformIfShared (app, selStation)) {
+		BarRpcCall_t *call;
+
+		if (!BarTransformIfShared (app, selStation) ||
+				(call = BarUiRpcNew (PIANO_REQUEST_ADD_SEED, &reqData,
+				sizeof (reqData))) == NULL) {
+			free (reqData.musicId);
 			return;
 		}
-		reqData.station = selStation;
+		BarUiRpcKeep (call, reqData.musicId);
+		((PianoRequestDataAddSeed_t *) call->data)->station = selStation;
 
-		BarUiMsg (&app->settings, MSG_INFO, "Adding music to station... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_ADD_SEED, &reqData);
+		call->msg = "Adding music to station... ";
+		call->callback = BarUiActAddMusicDone;
+		BarUiActDefaultPianoCallAsync (call);
+	}
+}
 
-		free (reqData.musicId);
+static void BarUiActBanSongDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
 
-		BarUiActDefaultEventcmd ("stationaddmusic");
+	if (pRet == PIANO_RET_OK && selSong == app->playlist) {
+		BarUiDoSkipSong (app->player);
 	}
+	BarUiActDefaultEventcmd ("songban");
 }
 
 /*	ban song
  */
 BarUiActCallback(BarUiActBanSong) {
-	PianoReturn_t pRet;
 	PianoStation_t *realStation;
 
 	assert (selStation != NULL);
 	assert (selSong != NULL);
 	assert (selSong->stationId != NULL);
 
-	if ((realStation = PianoFindStationById (app->ph.stations,
+	if ((realStation = PianoLookupStationById (&app->ph,
 			selSong->stationId)) == NULL) {
 		assert (0);
 		return;
@@ -137,35 +169,64 @@ BarUiActCallback(BarUiActBanSong) {
 	reqData.song = selSong;
 	reqData.rating = PIANO_RATE_BAN;
 
-	BarUiMsg (&app->settings, MSG_INFO, "Banning song... ");
-	if (BarUiActDefaultPianoCall (PIANO_REQUEST_RATE_SONG, &reqData) &&
-			selSong == app->playlist) {
-		BarUiDoSkipSong (app->player);
+	BarRpcCall_t * const call = BarUiRpcNew (PIANO_REQUEST_RATE_SONG,
+			&reqData, sizeof (reqData));
+	if (call != NULL) {
+		call->msg = "Banning song... ";
+		call->callback = BarUiActBanSongDone;
+		BarUiActDefaultPianoCallAsync (call);
 	}
-	BarUiActDefaultEventcmd ("songban");
+}
+
+static void BarUiActCreateStationDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("stationcreate");
+}
+
+/*	create station in the background, token and msg are copied
+ */
+static void BarUiActCreateStationAsync (BarApp_t *app,
+		PianoStation_t *selStation, PianoSong_t *selSong,
+		const PianoRequestDataCreateStation_t *reqData, const char *msg,
+		BarRpcCallback_t callback) {
+	PianoRequestDataCreateStation_t copy = *reqData;
+	BarRpcCall_t *call;
+	char *msgCopy;
+
+	copy.token = strdup (reqData->token);
+	msgCopy = strdup (msg);
+	if (copy.token == NULL || msgCopy == NULL ||
+			(call = BarUiRpcNew (PIANO_REQUEST_CREATE_STATION, &copy,
+			sizeof (copy))) == NULL) {
+		free (copy.token);
+		free (msgCopy);
+		return;
+	}
+	BarUiRpcKeep (call, copy.token);
+	call->msg = BarUiRpcKeep (call, msgCopy);
+	call->callback = callback;
+	BarUiActDefaultPianoCallAsync (call);
 }
 
 /*	create new station
  */
 BarUiActCallback(BarUiActCreateStation) {
-	PianoReturn_t pRet;
 	PianoRequestDataCreateStation_t reqData;
 
 	reqData.type = PIANO_MUSICTYPE_INVALID;
 	reqData.token = BarUiSelectMusicId (app, NULL,
 			"Create station from artist or title: ");
 	if (reqData.token != NULL) {
-		BarUiMsg (&app->settings, MSG_INFO, "Creating station... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_CREATE_STATION, &reqData);
+		BarUiActCreateStationAsync (app, selStation, selSong, &reqData,
+				"Creating station... ", BarUiActCreateStationDone);
 		free (reqData.token);
-		BarUiActDefaultEventcmd ("stationcreate");
 	}
 }
 
 /*	create new station
  */
 BarUiActCallback(BarUiActCreateStationFromSong) {
-	PianoReturn_t pRet;
 	PianoRequestDataCreateStation_t reqData;
 	char selectBuf[2];
 
@@ -185,16 +246,21 @@ BarUiActCallback(BarUiActCreateStationFromSong) {
 			break;
 	}
 	if (reqData.type != PIANO_MUSICTYPE_INVALID) {
-		BarUiMsg (&app->settings, MSG_INFO, "Creating station... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_CREATE_STATION, &reqData);
-		BarUiActDefaultEventcmd ("stationcreate");
+		BarUiActCreateStationAsync (app, selStation, selSong, &reqData,
+				"Creating station... ", BarUiActCreateStationDone);
 	}
 }
 
+static void BarUiActAddSharedStationDone (BarApp_t *app,
+		BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("stationaddshared");
+}
+
 /*	add shared station by id
  */
 BarUiActCallback(BarUiActAddSharedStation) {
-	PianoReturn_t pRet;
 	char stationId[50];
 	PianoRequestDataCreateStation_t reqData;
 
@@ -204,29 +270,27 @@ BarUiActCallback(BarUiActAddSharedStation) {
 	BarUiMsg (&app->settings, MSG_QUESTION, "Station id: ");
 	if (BarReadline (stationId, sizeof (stationId), "0123456789", app->rl,
 			BAR_RL_DEFAULT, -1) > 0) {
-		BarUiMsg (&app->settings, MSG_INFO, "Adding shared station... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_CREATE_STATION, &reqData);
-		BarUiActDefaultEventcmd ("stationaddshared");
+		BarUiActCreateStationAsync (app, selStation, selSong, &reqData,
+				"Adding shared station... ", BarUiActAddSharedStationDone);
 	}
 }
 
-/*	delete current station
- */
-BarUiActCallback(BarUiActDeleteStation) {
-	PianoReturn_t pRet;
+static void BarUiActDeleteStationDone (BarApp_t *app, BarRpcCall_t *call) {
+	PianoStation_t *selStation = call->station;
+	PianoSong_t *selSong = call->song;
+	const PianoReturn_t pRet = call->pRet;
 
-	assert (selStation != NULL);
-
-	BarUiMsg (&app->settings, MSG_QUESTION, "Really delete \"%s\"? [yN] ",
-			selStation->name);
-	if (BarReadlineYesNo (false, app->rl)) {
-		BarUiMsg (&app->settings, MSG_INFO, "Deleting station... ");
-		if (BarUiActDefaultPianoCall (PIANO_REQUEST_DELETE_STATION,
-				selStation) && selStation == app->curStation) {
+	if (pRet == PIANO_RET_OK) {
+		/* the station struct is gone */
+		BarUiRpcForget (app, selStation);
+		if (selStation == app->prefetch.station) {
+			BarUiPrefetchDiscard (app);
+		}
+		if (selStation == app->curStation) {
 			BarUiDoSkipSong (app->player);
 			if (app->playlist != NULL) {
 				/* drain playlist */
-				PianoDestroyPlaylist (PianoListNextP (app->playlist));
+				BarUiDestroyPlaylist (app, PianoListNextP (app->playlist));
 				app->playlist->head.next = NULL;
 				selSong = NULL;
 			}
@@ -234,9 +298,29 @@ BarUiActCallback(BarUiActDeleteStation) {
 			/* XXX: usually we shoudn’t touch cur*, but DELETE_STATION destroys
 			 * station struct */
 			app->curStation = NULL;
-			selStation = NULL;
+		} else if (selStation == app->nextStation) {
+			app->nextStation = NULL;
+		}
+		selStation = NULL;
+	}
+	BarUiActDefaultEventcmd ("stationdelete");
+}
+
+/*	delete current station
+ */
+BarUiActCallback(BarUiActDeleteStation) {
+	assert (selStation != NULL);
+
+	BarUiMsg (&app->settings, MSG_QUESTION, "Really delete \"%s\"? [yN] ",
+			selStation->name);
+	if (BarReadlineYesNo (false, app->rl)) {
+		BarRpcCall_t * const call = BarUiRpcNew (PIANO_REQUEST_DELETE_STATION,
+				selStation, 0);
+		if (call != NULL) {
+			call->msg = "Deleting station... ";
+			call->callback = BarUiActDeleteStationDone;
+			BarUiActDefaultPianoCallAsync (call);
 		}
-		BarUiActDefaultEventcmd ("stationdelete");
 	}
 }
 
@@ -258,6 +342,13 @@ BarUiActCallback(BarUiActExplain) {
 	BarUiActDefaultEventcmd ("songexplain");
 }
 
+static void BarUiActStationFromGenreDone (BarApp_t *app,
+		BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("stationaddgenre");
+}
+
 /*	choose genre station and add it as shared station
  */
 BarUiActCallback(BarUiActStationFromGenre) {
@@ -312,12 +403,13 @@ BarUiActCallback(BarUiActStationFromGenre) {
 
 	/* create station */
 	PianoRequestDataCreateStation_t reqData;
+	char msg[256];
 	reqData.token = curGenre->musicId;
 	reqData.type = PIANO_MUSICTYPE_INVALID;
-	BarUiMsg (&app->settings, MSG_INFO, "Adding genre station \"%s\"... ",
+	snprintf (msg, sizeof (msg), "Adding genre station \"%s\"... ",
 			curGenre->name);
-	BarUiActDefaultPianoCall (PIANO_REQUEST_CREATE_STATION, &reqData);
-	BarUiActDefaultEventcmd ("stationaddgenre");
+	BarUiActCreateStationAsync (app, selStation, selSong, &reqData, msg,
+			BarUiActStationFromGenreDone);
 }
 
 /*	print verbose song information
@@ -330,15 +422,25 @@ BarUiActCallback(BarUiActSongInfo) {
 	/* print real station if quickmix */
 	BarUiPrintSong (&app->settings, selSong,
 			selStation->isQuickMix ?
-			PianoFindStationById (app->ph.stations, selSong->stationId) :
+			PianoLookupStationById (&app->ph, selSong->stationId) :
 			NULL);
 }
 
 /*	print some debugging information
  */
 BarUiActCallback(BarUiActDebug) {
+	HttpStats_t httpStats;
+	unsigned int queueSongs, queueSeconds;
+
 	assert (selSong != NULL);
 
+	/* the worker updates them while a background call runs */
+	EnterCriticalSection (&app->rpc.httpLock);
+	HttpGetStats (app->http2, &httpStats);
+	LeaveCriticalSection (&app->rpc.httpLock);
+	BarUiQueueDepth (app, &queueSongs, &queueSeconds);
+	const DWORD running = GetTickCount () - app->loop.started;
+
 	/* print debug-alike infos */
 	BarUiMsg (&app->settings, MSG_DEBUG,
 			"album:\t%s\n"
@@ -350,9 +452,21 @@ BarUiActCallback(BarUiActDebug) {
 			"fileGain:\t%f\n"
 			"musicId:\t%s\n"
 			"rating:\t%i\n"
+			"songIdentity:\t%s\n"
 			"stationId:\t%s\n"
 			"title:\t%s\n"
-			"trackToken:\t%s\n",
+			"trackToken:\t%s\n"
+			"rpc calls:\t%lu (%lu allocated buffers)\n"
+			"connections:\t%lu opened, %lu reused, %lu redialed\n"
+			"tls handshakes:\t%lu (%lu resumed, %.1f ms average)\n"
+			"rpc responses:\t%llu bytes received, %llu decoded (last %lu/%lu)\n"
+			"queue:\t%u songs, %u:%02u (target %u songs, %u minutes)\n"
+			"playlist prefetch:\t%lu fetches, %lu hits, %lu misses, "
+			"last gap %lu ms\n"
+			"audio url age:\t%lu s at playback (max %lu s), "
+			"%lu songs expired, %lu refetched\n"
+			"repeats:\t%lu dropped (window %u, %lu bytes)\n"
+			"main loop:\t%.1f wakeups/min, song end noticed after %lu ms\n",
 			selSong->album,
 			selSong->artist,
 			selSong->audioFormat,
@@ -362,22 +476,59 @@ BarUiActCallback(BarUiActDebug) {
 			selSong->fileGain,
 			selSong->musicId,
 			selSong->rating,
+			selSong->songIdentity,
 			selSong->stationId,
 			selSong->title,
-			selSong->trackToken);
+			selSong->trackToken,
+			app->requests.calls,
+			app->requests.allocs,
+			httpStats.connects,
+			httpStats.reused,
+			httpStats.redials,
+			httpStats.handshakes,
+			httpStats.resumed,
+			httpStats.handshakes > 0 ?
+			httpStats.handshakeTime * 1000 / httpStats.handshakes : 0.0,
+			httpStats.received,
+			httpStats.decoded,
+			(unsigned long) httpStats.lastReceived,
+			(unsigned long) httpStats.lastDecoded,
+			queueSongs,
+			queueSeconds / 60,
+			queueSeconds % 60,
+			app->settings.queueSongs,
+			app->settings.queueMinutes,
+			app->prefetch.fetches,
+			app->prefetch.hits,
+			app->prefetch.misses,
+			app->prefetch.lastGap,
+			app->prefetch.lastUrlAge,
+			app->prefetch.maxUrlAge,
+			app->prefetch.expired,
+			app->prefetch.refetched,
+			app->prefetch.repeats,
+			app->settings.repeatWindow,
+			(unsigned long) BarRecentSize (&app->recent),
+			running > 0 ? app->loop.wakeups * 60000.0 / running : 0.0,
+			app->loop.lastEndLatency);
+}
+
+static void BarUiActLoveSongDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("songlove");
 }
 
 /*	rate current song
  */
 BarUiActCallback(BarUiActLoveSong) {
-	PianoReturn_t pRet;
 	PianoStation_t *realStation;
 
 	assert (selStation != NULL);
 	assert (selSong != NULL);
 	assert (selSong->stationId != NULL);
 
-	if ((realStation = PianoFindStationById (app->ph.stations,
+	if ((realStation = PianoLookupStationById (&app->ph,
 			selSong->stationId)) == NULL) {
 		assert (0);
 		return;
@@ -390,9 +541,13 @@ BarUiActCallback(BarUiActLoveSong) {
 	reqData.song = selSong;
 	reqData.rating = PIANO_RATE_LOVE;
 
-	BarUiMsg (&app->settings, MSG_INFO, "Loving song... ");
-	BarUiActDefaultPianoCall (PIANO_REQUEST_RATE_SONG, &reqData);
-	BarUiActDefaultEventcmd ("songlove");
+	BarRpcCall_t * const call = BarUiRpcNew (PIANO_REQUEST_RATE_SONG,
+			&reqData, sizeof (reqData));
+	if (call != NULL) {
+		call->msg = "Loving song... ";
+		call->callback = BarUiActLoveSongDone;
+		BarUiActDefaultPianoCallAsync (call);
+	}
 }
 
 /*	skip song
@@ -422,10 +577,15 @@ BarUiActCallback(BarUiActTogglePause) {
 		BarPlayer2Play(app->player);
 }
 
+static void BarUiActRenameStationDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("stationrename");
+}
+
 /*	rename current station
  */
 BarUiActCallback(BarUiActRenameStation) {
-	PianoReturn_t pRet;
 	char lineBuf[100];
 
 	assert (selStation != NULL);
@@ -438,11 +598,18 @@ BarUiActCallback(BarUiActRenameStation) {
 		}
 
 		reqData.station = selStation;
-		reqData.newName = lineBuf;
+		reqData.newName = strdup (lineBuf);
 
-		BarUiMsg (&app->settings, MSG_INFO, "Renaming station... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_RENAME_STATION, &reqData);
-		BarUiActDefaultEventcmd ("stationrename");
+		BarRpcCall_t * const call = BarUiRpcNew (
+				PIANO_REQUEST_RENAME_STATION, &reqData, sizeof (reqData));
+		if (call == NULL) {
+			free (reqData.newName);
+			return;
+		}
+		BarUiRpcKeep (call, reqData.newName);
+		call->msg = "Renaming station... ";
+		call->callback = BarUiActRenameStationDone;
+		BarUiActDefaultPianoCallAsync (call);
 	}
 }
 
@@ -453,28 +620,37 @@ BarUiActCallback(BarUiActSelectStation) {
 			"Select station: ", NULL, app->settings.autoselect);
 	if (newStation != NULL) {
 		app->nextStation = newStation;
+		BarUiPrefetchDiscard (app);
 		BarUiDoSkipSong (app->player);
 		if (app->playlist != NULL) {
 			/* drain playlist */
-			PianoDestroyPlaylist (PianoListNextP (app->playlist));
+			BarUiDestroyPlaylist (app, PianoListNextP (app->playlist));
 			app->playlist->head.next = NULL;
 		}
 	}
 }
 
+static void BarUiActTempBanSongDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	if (pRet == PIANO_RET_OK && selSong == app->playlist) {
+		BarUiDoSkipSong (app->player);
+	}
+	BarUiActDefaultEventcmd ("songshelf");
+}
+
 /*	ban song for 1 month
  */
 BarUiActCallback(BarUiActTempBanSong) {
-	PianoReturn_t pRet;
-
 	assert (selSong != NULL);
 
-	BarUiMsg (&app->settings, MSG_INFO, "Putting song on shelf... ");
-	if (BarUiActDefaultPianoCall (PIANO_REQUEST_ADD_TIRED_SONG, selSong) &&
-			selSong == app->playlist) {
-		BarUiDoSkipSong (app->player);
+	BarRpcCall_t * const call = BarUiRpcNew (PIANO_REQUEST_ADD_TIRED_SONG,
+			selSong, 0);
+	if (call != NULL) {
+		call->msg = "Putting song on shelf... ";
+		call->callback = BarUiActTempBanSongDone;
+		BarUiActDefaultPianoCallAsync (call);
 	}
-	BarUiActDefaultEventcmd ("songshelf");
 }
 
 /*	print upcoming songs
@@ -529,9 +705,13 @@ static void BarUiActQuickmixCallback (BarApp_t *app, char *buf) {
 /*	if current station is a quickmix: select stations that are played in
  *	quickmix
  */
-BarUiActCallback(BarUiActSelectQuickMix) {
-	PianoReturn_t pRet;
+static void BarUiActSelectQuickMixDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	BarUiActDefaultEventcmd ("stationquickmixtoggle");
+}
 
+BarUiActCallback(BarUiActSelectQuickMix) {
 	assert (selStation != NULL);
 
 	if (selStation->isQuickMix) {
@@ -541,9 +721,13 @@ BarUiActCallback(BarUiActSelectQuickMix) {
 				BarUiActQuickmixCallback, false)) != NULL) {
 			toggleStation->useQuickMix = !toggleStation->useQuickMix;
 		}
-		BarUiMsg (&app->settings, MSG_INFO, "Setting QuickMix stations... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_SET_QUICKMIX, NULL);
-		BarUiActDefaultEventcmd ("stationquickmixtoggle");
+		BarRpcCall_t * const call = BarUiRpcNew (PIANO_REQUEST_SET_QUICKMIX,
+				NULL, 0);
+		if (call != NULL) {
+			call->msg = "Setting QuickMix stations... ";
+			call->callback = BarUiActSelectQuickMixDone;
+			BarUiActDefaultPianoCallAsync (call);
+		}
 	} else {
 		BarUiMsg (&app->settings, MSG_ERR, "Please select a QuickMix station first.\n");
 	}
@@ -567,7 +751,7 @@ BarUiActCallback(BarUiActHistory) {
 				app->rl);
 		if (histSong != NULL) {
 			BarKeyShortcutId_t action;
-			PianoStation_t *songStation = PianoFindStationById (app->ph.stations,
+			PianoStation_t *songStation = PianoLookupStationById (&app->ph,
 					histSong->stationId);
 
 			if (songStation == NULL) {
@@ -595,11 +779,21 @@ BarUiActCallback(BarUiActHistory) {
 	}
 }
 
+static void BarUiActBookmarkDone (BarApp_t *app, BarRpcCall_t *call) {
+	BarUiActDoneVars (call);
+
+	if (call->type == PIANO_REQUEST_BOOKMARK_SONG) {
+		BarUiActDefaultEventcmd ("songbookmark");
+	} else {
+		BarUiActDefaultEventcmd ("artistbookmark");
+	}
+}
+
 /*	create song bookmark
  */
 BarUiActCallback(BarUiActBookmark) {
-	PianoReturn_t pRet;
 	char selectBuf[2];
+	BarRpcCall_t *call = NULL;
 
 	assert (selSong != NULL);
 
@@ -607,13 +801,19 @@ BarUiActCallback(BarUiActBookmark) {
 	BarReadline (selectBuf, sizeof (selectBuf), "sa", app->rl,
 			BAR_RL_FULLRETURN, -1);
 	if (selectBuf[0] == 's') {
-		BarUiMsg (&app->settings, MSG_INFO, "Bookmarking song... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_BOOKMARK_SONG, selSong);
-		BarUiActDefaultEventcmd ("songbookmark");
+		if ((call = BarUiRpcNew (PIANO_REQUEST_BOOKMARK_SONG, selSong,
+				0)) != NULL) {
+			call->msg = "Bookmarking song... ";
+		}
 	} else if (selectBuf[0] == 'a') {
-		BarUiMsg (&app->settings, MSG_INFO, "Bookmarking artist... ");
-		BarUiActDefaultPianoCall (PIANO_REQUEST_BOOKMARK_ARTIST, selSong);
-		BarUiActDefaultEventcmd ("artistbookmark");
+		if ((call = BarUiRpcNew (PIANO_REQUEST_BOOKMARK_ARTIST, selSong,
+				0)) != NULL) {
+			call->msg = "Bookmarking artist... ";
+		}
+	}
+	if (call != NULL) {
+		call->callback = BarUiActBookmarkDone;
+		BarUiActDefaultPianoCallAsync (call);
 	}
 }
 
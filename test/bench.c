@@ -0,0 +1,867 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* libpiano benchmark: PianoResponse over the recorded responses in
+ * test/corpus, PianoRequest for every request type and the codecs underneath
+ * them, the latter before and after. Prints one line per benchmark in the
+ * format of Go’s testing package (benchstat reads it):
+ *
+ *   BenchmarkResponse/get_playlist  20000  9500 ns/op  4200 B/op  30 allocs/op
+ *
+ * Allocations are counted by replacing malloc, which works with glibc
+ * only. They include json-c’s. */
+
+#include "config.h"
+
+#include <assert.h>
+#include <json/json.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "piano.h"
+#include "piano_private.h"
+#include "crypt.h"
+#include "fixture.h"
+
+/* run each benchmark for at least this long */
+#define BENCH_TIME_NS 200000000ull
+/* songs of the simulated session, four minutes each make a day */
+#define BENCH_SESSION_SONGS 360
+/* items of the generated feedback response and list benchmarks */
+#define BENCH_FEEDBACK 5000
+/* bytes per operation of the codec benchmarks, about a large request body */
+#define BENCH_CODEC_SIZE 1024
+
+/* keys of the android partner, see contrib/pianobar.1 */
+#define BENCH_PARTNER_USER "android"
+#define BENCH_PARTNER_PASSWORD "AC7IBG09A3DTSYM4R41UJWL07VLN8JI7"
+#define BENCH_DEVICE "android-generic"
+#define BENCH_DECRYPT "R=U!LH$O2B#"
+#define BENCH_ENCRYPT "6#26FRL$ZWD"
+
+/* allocation counters, see malloc below; live and peak are usable sizes */
+static unsigned long long benchAllocs, benchBytes;
+static size_t benchLive, benchPeak;
+
+extern void *__libc_malloc (size_t);
+extern void *__libc_calloc (size_t, size_t);
+extern void *__libc_realloc (void *, size_t);
+extern void __libc_free (void *);
+
+static void *BenchLive (void * const p) {
+	if (p != NULL) {
+		benchLive += malloc_usable_size (p);
+		if (benchLive > benchPeak) {
+			benchPeak = benchLive;
+		}
+	}
+	return p;
+}
+
+void *malloc (size_t size) {
+	++benchAllocs;
+	benchBytes += size;
+	return BenchLive (__libc_malloc (size));
+}
+
+void *calloc (size_t n, size_t size) {
+	++benchAllocs;
+	benchBytes += n*size;
+	return BenchLive (__libc_calloc (n, size));
+}
+
+void *realloc (void *p, size_t size) {
+	++benchAllocs;
+	benchBytes += size;
+	const size_t old = p != NULL ? malloc_usable_size (p) : 0;
+	void * const ret = __libc_realloc (p, size);
+	if (ret != NULL || size == 0) {
+		benchLive -= old;
+	}
+	return BenchLive (ret);
+}
+
+void free (void *p) {
+	if (p != NULL) {
+		benchLive -= malloc_usable_size (p);
+	}
+	__libc_free (p);
+}
+
+static uint64_t BenchNow (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/*	read file
+ *	@return NUL-terminated contents or NULL
+ */
+static char *BenchSlurp (const char * const path, size_t * const size) {
+	FILE * const fp = fopen (path, "rb");
+	char *buf = NULL;
+	long len;
+
+	if (fp == NULL) {
+		return NULL;
+	}
+	if (fseek (fp, 0, SEEK_END) == 0 && (len = ftell (fp)) >= 0 &&
+			fseek (fp, 0, SEEK_SET) == 0 &&
+			(buf = malloc (len + 1)) != NULL) {
+		*size = fread (buf, 1, len, fp);
+		buf[*size] = '\0';
+	}
+	fclose (fp);
+	return buf;
+}
+
+/* totals of one benchmark run */
+typedef struct {
+	unsigned long long n, ns, allocs, bytes;
+} BenchResult_t;
+
+static void BenchPrint (const char * const kind, const char * const name,
+		const BenchResult_t * const r) {
+	printf ("Benchmark%s/%s\t%llu\t%.1f ns/op\t%llu B/op\t%llu allocs/op\n",
+			kind, name, r->n, (double) r->ns / r->n, r->bytes / r->n,
+			r->allocs / r->n);
+	fflush (stdout);
+}
+
+/*	same, with throughput for size bytes per operation
+ */
+static void BenchPrintBytes (const char * const kind, const char * const name,
+		const BenchResult_t * const r, const size_t size) {
+	printf ("Benchmark%s/%s\t%llu\t%.1f ns/op\t%.2f MB/s\t%llu B/op\t"
+			"%llu allocs/op\n", kind, name, r->n, (double) r->ns / r->n,
+			(double) size * r->n * 1000.0 / r->ns, r->bytes / r->n,
+			r->allocs / r->n);
+	fflush (stdout);
+}
+
+/*	parse response again and again, only PianoResponse itself is measured
+ *	@return false if it did not succeed
+ */
+static bool BenchResponse (Fixture_t * const b, const FixtureType_t * const t,
+		char * const response, const size_t length) {
+	/* low-level type, its response reaches PianoResponse as rate_song’s */
+	const FixtureType_t parsed = {t->name,
+			t->type == PIANO_REQUEST_ADD_FEEDBACK ? PIANO_REQUEST_RATE_SONG :
+			t->type, t->step};
+	BenchResult_t r;
+	PianoRequest_t req;
+
+	memset (&r, 0, sizeof (r));
+	memset (&req, 0, sizeof (req));
+	do {
+		void * const data = FixtureData (b, &parsed);
+
+		req.type = parsed.type;
+		req.data = data;
+		req.responseData = response;
+		req.responseDataLength = length;
+
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		const PianoReturn_t ret = PianoResponse (&b->ph, &req);
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+
+		if (ret != PIANO_RET_OK && ret != PIANO_RET_CONTINUE_REQUEST) {
+			fprintf (stderr, "%s: %s\n", t->name, PianoErrorToStr (ret));
+			return false;
+		}
+		FixtureFree (b, &parsed);
+	} while (r.ns < BENCH_TIME_NS);
+
+	BenchPrint ("Response", t->name, &r);
+	return true;
+}
+
+/*	serialize request again and again, reusing its buffers like the
+ *	application does
+ *	@return false if it did not succeed
+ */
+static bool BenchRequest (Fixture_t * const b, const FixtureType_t * const t) {
+	BenchResult_t r;
+	PianoRequest_t req;
+	bool ok = true;
+
+	memset (&r, 0, sizeof (r));
+	memset (&req, 0, sizeof (req));
+	do {
+		/* responses are not parsed, nothing to free */
+		req.data = t->type == PIANO_REQUEST_DELETE_STATION ? &b->station :
+				FixtureData (b, t);
+
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		const PianoReturn_t ret = PianoRequest (&b->ph, &req, t->type);
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+
+		if (t->type == PIANO_REQUEST_RENAME_STATION) {
+			free (b->station.name);
+		}
+		if (ret != PIANO_RET_OK) {
+			fprintf (stderr, "%s: %s\n", t->name, PianoErrorToStr (ret));
+			ok = false;
+			break;
+		}
+		PianoResetRequest (&req);
+	} while (r.ns < BENCH_TIME_NS);
+
+	PianoDestroyRequest (&req);
+	if (ok) {
+		BenchPrint ("Request", t->name, &r);
+	}
+	return ok;
+}
+
+/*	hex codec of the initial import, one snprintf/strtol per byte
+ */
+static void BenchHexEncodeBefore (const unsigned char * const input,
+		const size_t size, char * const output) {
+	for (size_t i = 0; i < size; i++) {
+		snprintf (&output[i*2], 3, "%02x", input[i]);
+	}
+}
+
+static void BenchHexDecodeBefore (const char * const input,
+		const size_t size, unsigned char * const output) {
+	for (size_t i = 0; i < size; i++) {
+		char hex[3];
+		memcpy (hex, &input[i*2], 2);
+		hex[2] = '\0';
+		output[i] = (unsigned char) strtol (hex, NULL, 16);
+	}
+}
+
+/* hex kernels by name, “before” is the code above */
+static const char * const benchHexKernels[] = {"scalar", "sse2", "avx2"};
+
+/*	hex-encode or decode BENCH_CODEC_SIZE bytes again and again with kernel,
+ *	or the old code if before is set
+ *	@return false if it did not succeed
+ */
+static bool BenchHex (const char * const filter, const bool decode,
+		const bool before, const PianoHexKernel_t kernel) {
+	unsigned char data[BENCH_CODEC_SIZE];
+	char hex[BENCH_CODEC_SIZE*2+1];
+	char name[64];
+	BenchResult_t r;
+	bool ok = true;
+
+	/* filtered by the whole name, printed as BenchmarkHex/… */
+	snprintf (name, sizeof (name), "hex/%s/%s", decode ? "decode" : "encode",
+			before ? "before" : benchHexKernels[kernel]);
+	if (strstr (name, filter) == NULL) {
+		return true;
+	}
+	if (!before && !PianoHexUseKernel (kernel)) {
+		fprintf (stderr, "%s: not supported by this cpu\n", name);
+		return true;
+	}
+
+	for (size_t i = 0; i < sizeof (data); i++) {
+		data[i] = (unsigned char) (i * 131 + 7);
+	}
+	BenchHexEncodeBefore (data, sizeof (data), hex);
+
+	memset (&r, 0, sizeof (r));
+	do {
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		if (decode && before) {
+			BenchHexDecodeBefore (hex, sizeof (data), data);
+		} else if (decode) {
+			ok = PianoHexDecode (hex, sizeof (data), data);
+		} else if (before) {
+			BenchHexEncodeBefore (data, sizeof (data), hex);
+		} else {
+			PianoHexEncode (data, sizeof (data), hex);
+		}
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+	} while (ok && r.ns < BENCH_TIME_NS);
+
+	if (ok) {
+		BenchPrintBytes ("Hex", &name[strlen ("hex/")], &r, sizeof (data));
+	} else {
+		fprintf (stderr, "%s: cannot decode\n", name);
+	}
+	return ok;
+}
+
+/*	PianoEncryptString of the initial import: pads a copy of the body,
+ *	encrypts it and hex-encodes into another allocation
+ */
+static char *BenchEncryptBefore (PianoCipher_t h, const char * const s) {
+	const size_t inputLen = strlen (s);
+	const size_t paddedInputLen = inputLen % 8 == 0 ? inputLen :
+			inputLen + (8 - inputLen % 8);
+	unsigned char * const paddedInput = calloc (paddedInputLen + 1, 1);
+
+	if (paddedInput == NULL) {
+		return NULL;
+	}
+	memcpy (paddedInput, s, inputLen);
+	if (!PianoCryptData (h, paddedInput, paddedInputLen, true, false)) {
+		free (paddedInput);
+		return NULL;
+	}
+
+	char * const hexOutput = calloc (paddedInputLen*2 + 1, 1);
+	if (hexOutput != NULL) {
+		BenchHexEncodeBefore (paddedInput, paddedInputLen, hexOutput);
+	}
+	free (paddedInput);
+	return hexOutput;
+}
+
+/*	encrypt the body of request type t again and again, as a whole into new
+ *	allocations like the initial import (before) or after the cached auth
+ *	prefix in place (after), where PianoRequest wrote it
+ *	@return false if it did not succeed
+ */
+static bool BenchEncrypt (Fixture_t * const b, const FixtureType_t * const t,
+		const bool before) {
+	PianoCipher_t h = b->ph.partner.out;
+	PianoRequest_t req;
+	BenchResult_t r;
+	char name[64];
+	size_t size;
+	bool ok = true;
+
+	/* plaintext of the body, as the request writes it */
+	memset (&req, 0, sizeof (req));
+	req.data = t->type == PIANO_REQUEST_DELETE_STATION ? &b->station :
+			FixtureData (b, t);
+	if (PianoRequest (&b->ph, &req, t->type) != PIANO_RET_OK) {
+		return false;
+	}
+	if (t->type == PIANO_REQUEST_RENAME_STATION) {
+		free (b->station.name);
+	}
+	char * const plain = PianoDecryptString (h, req.postData, &size);
+	const char * const prefix = b->ph.user.authPrefix;
+	PianoDestroyRequest (&req);
+	if (plain == NULL || prefix == NULL) {
+		free (plain);
+		return false;
+	}
+	const size_t prefixLen = strlen (prefix), plainLen = strlen (plain),
+			tailLen = plainLen - prefixLen/2;
+	char * const buf = malloc (prefixLen + PianoEncryptedSize (tailLen));
+	if (buf == NULL) {
+		free (plain);
+		return false;
+	}
+
+	memset (&r, 0, sizeof (r));
+	do {
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		if (before) {
+			char * const postData = BenchEncryptBefore (h, plain);
+			ok = postData != NULL;
+			free (postData);
+		} else {
+			memcpy (buf, prefix, prefixLen);
+			memcpy (&buf[prefixLen], &plain[prefixLen/2], tailLen);
+			ok = PianoEncryptInPlace (h, &buf[prefixLen], tailLen);
+		}
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+	} while (ok && r.ns < BENCH_TIME_NS);
+
+	free (buf);
+	free (plain);
+	snprintf (name, sizeof (name), "%s/%s", t->name,
+			before ? "before" : "after");
+	if (ok) {
+		BenchPrint ("Encrypt", name, &r);
+	} else {
+		fprintf (stderr, "encrypt/%s: failed\n", name);
+	}
+	return ok;
+}
+
+/*	blowfish-encrypt BENCH_CODEC_SIZE bytes again and again, either block by
+ *	block with the library or with the interleaved kernel
+ *	@return false if it did not succeed
+ */
+static bool BenchBlowfish (const char * const filter, const bool interleaved) {
+	unsigned char data[BENCH_CODEC_SIZE];
+	char name[64];
+	BenchResult_t r;
+	PianoCipher_t h;
+	bool ok = true;
+
+	snprintf (name, sizeof (name), "blowfish/%s",
+			interleaved ? "interleaved" : "single");
+	if (strstr (name, filter) == NULL) {
+		return true;
+	}
+	if (PianoCryptInit (&h, BENCH_ENCRYPT, strlen (BENCH_ENCRYPT)) !=
+			PIANO_RET_OK) {
+		return false;
+	}
+
+	for (size_t i = 0; i < sizeof (data); i++) {
+		data[i] = (unsigned char) (i * 131 + 7);
+	}
+
+	memset (&r, 0, sizeof (r));
+	do {
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		ok = PianoCryptData (h, data, sizeof (data), true, interleaved);
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+	} while (ok && r.ns < BENCH_TIME_NS);
+
+	PianoCryptDestroy (h);
+	if (ok) {
+		BenchPrintBytes ("Blowfish", &name[strlen ("blowfish/")], &r,
+				sizeof (data));
+	} else {
+		/* the kernel disagreed with the library and is not used */
+		fprintf (stderr, "%s: failed\n", name);
+	}
+	return ok;
+}
+
+/*	generate station info with n feedback items, half of them positive
+ *	@return response or NULL
+ */
+static char *BenchFeedbackResponse (const size_t n, size_t * const length) {
+	const size_t size = n*256 + 256;
+	char * const buf = malloc (size);
+	size_t len = 0;
+
+	if (buf == NULL) {
+		return NULL;
+	}
+	len += snprintf (&buf[len], size - len,
+			"{\"stat\": \"ok\", \"result\": {\"feedback\": {\"thumbsUp\": [");
+	for (size_t i = 0; i < n; i++) {
+		if (i == n/2) {
+			len += snprintf (&buf[len], size - len, "], \"thumbsDown\": [");
+		} else if (i > 0) {
+			len += snprintf (&buf[len], size - len, ", ");
+		}
+		len += snprintf (&buf[len], size - len, "{\"feedbackId\": "
+				"\"%018zu\", \"songName\": \"Song %zu\", \"artistName\": "
+				"\"Artist %zu\", \"isPositive\": %s, \"musicToken\": "
+				"\"%016zx\", \"dateCreated\": {\"time\": %zu}, "
+				"\"trackLength\": %zu}", i, i, i % 100,
+				i < n/2 ? "true" : "false", i*7919, 1500000000000 + i,
+				150 + i % 300);
+	}
+	len += snprintf (&buf[len], size - len, "]}}}");
+	assert (len < size);
+
+	*length = len;
+	return buf;
+}
+
+/*	feedback loop of the initial import’s GET_STATION_INFO parser: json-c
+ *	tree, every song appended to the bare list (walks to the tail)
+ *	@return false if it did not succeed
+ */
+static bool BenchFeedbackBefore (const char * const response) {
+	static const char * const keys[] = {"thumbsUp", "thumbsDown"};
+	json_object * const j = json_tokener_parse (response);
+	json_object *result, *feedback;
+	PianoSong_t *list = NULL;
+
+	if (j == NULL || !json_object_object_get_ex (j, "result", &result) ||
+			!json_object_object_get_ex (result, "feedback", &feedback)) {
+		json_object_put (j);
+		return false;
+	}
+	for (size_t i = 0; i < sizeof (keys)/sizeof (*keys); i++) {
+		json_object *val;
+		if (!json_object_object_get_ex (feedback, keys[i], &val)) {
+			continue;
+		}
+		for (size_t k = 0; k < json_object_array_length (val); k++) {
+			json_object * const o = json_object_array_get_idx (val, k);
+			PianoSong_t * const song = calloc (1, sizeof (*song));
+			json_object *v;
+
+			if (song == NULL) {
+				break;
+			}
+			if (json_object_object_get_ex (o, "songName", &v)) {
+				song->title = strdup (json_object_get_string (v));
+			}
+			if (json_object_object_get_ex (o, "artistName", &v)) {
+				song->artist = strdup (json_object_get_string (v));
+			}
+			if (json_object_object_get_ex (o, "feedbackId", &v)) {
+				song->feedbackId = strdup (json_object_get_string (v));
+			}
+			song->rating = json_object_object_get_ex (o, "isPositive", &v) &&
+					json_object_get_boolean (v) ? PIANO_RATE_LOVE :
+					PIANO_RATE_BAN;
+			song->length = json_object_object_get_ex (o, "trackLength", &v) ?
+					json_object_get_int (v) : 0;
+			list = PianoListAppendP (list, song);
+		}
+	}
+	json_object_put (j);
+
+	/* not interned, PianoDestroyPlaylist would release the artist */
+	while (list != NULL) {
+		PianoSong_t * const song = list;
+		list = (PianoSong_t *) song->head.next;
+		free (song->title);
+		free (song->artist);
+		free (song->feedbackId);
+		free (song);
+	}
+	return true;
+}
+
+/*	run BenchFeedbackBefore on response again and again
+ *	@return false if it did not succeed
+ */
+static bool BenchResponseBefore (const char * const name,
+		const char * const response) {
+	BenchResult_t r;
+	bool ok = true;
+
+	memset (&r, 0, sizeof (r));
+	do {
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		ok = BenchFeedbackBefore (response);
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+	} while (ok && r.ns < BENCH_TIME_NS);
+
+	if (ok) {
+		BenchPrint ("Response", name, &r);
+	} else {
+		fprintf (stderr, "%s: cannot parse\n", name);
+	}
+	return ok;
+}
+
+/*	one rpc of the session: serialize the request and parse its response
+ *	@return false if it did not succeed
+ */
+static bool BenchSessionCall (Fixture_t * const b, PianoRequest_t * const req,
+		const FixtureType_t * const t, char * const response,
+		const size_t length) {
+	req->data = FixtureData (b, t);
+	if (PianoRequest (&b->ph, req, t->type) != PIANO_RET_OK) {
+		return false;
+	}
+	req->responseData = response;
+	req->responseDataLength = length;
+	const PianoReturn_t ret = PianoResponse (&b->ph, req);
+	/* the corpus is not the request’s to free */
+	req->responseData = NULL;
+	req->responseDataLength = 0;
+	PianoResetRequest (req);
+	return ret == PIANO_RET_OK;
+}
+
+/*	a day of listening like pianobar does it: songs are queued four at a
+ *	time and destroyed one by one once played, some are rated, station info
+ *	is shown now and then and the station list refreshed every few hours.
+ *	Reports the heap’s peak and, once everything is freed again, how much of
+ *	it stays allocated and how much is free but not returned to the system
+ *	@return false if it did not succeed
+ */
+static bool BenchSession (Fixture_t * const b, char ** const responses,
+		size_t * const lengths) {
+	static const char * const names[] = {"get_stations", "get_playlist",
+			"rate_song", "get_station_info"};
+	const FixtureType_t *types[sizeof (names)/sizeof (*names)];
+	char *response[sizeof (names)/sizeof (*names)];
+	size_t length[sizeof (names)/sizeof (*names)];
+	BenchResult_t r;
+	PianoRequest_t req;
+	bool ok = true;
+
+	for (size_t i = 0; i < sizeof (names)/sizeof (*names); i++) {
+		types[i] = NULL;
+		for (size_t k = 0; k < fixtureTypeCount; k++) {
+			if (strcmp (fixtureTypes[k].name, names[i]) == 0) {
+				types[i] = &fixtureTypes[k];
+				response[i] = responses[k];
+				length[i] = lengths[k];
+			}
+		}
+		assert (types[i] != NULL && response[i] != NULL);
+	}
+
+	/* leftovers of the other benchmarks are not counted */
+	FixtureClearStations (&b->ph);
+	malloc_trim (0);
+	const size_t live = benchLive, heapFree = mallinfo2 ().fordblks;
+	benchPeak = benchLive;
+
+	memset (&r, 0, sizeof (r));
+	memset (&req, 0, sizeof (req));
+	do {
+		PianoSong_t *queue = NULL;
+
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		for (size_t song = 0; ok && song < BENCH_SESSION_SONGS; song++) {
+			if (song % 120 == 0) {
+				FixtureClearStations (&b->ph);
+				ok = BenchSessionCall (b, &req, types[0], response[0],
+						length[0]);
+			}
+			if (queue == NULL || queue->head.next == NULL) {
+				ok = ok && BenchSessionCall (b, &req, types[1], response[1],
+						length[1]);
+				/* one by one, like BarUiPlaylistJoin */
+				PianoSong_t *next = b->playlist.retPlaylist;
+				while (next != NULL) {
+					PianoSong_t * const add = next;
+					next = (PianoSong_t *) add->head.next;
+					add->head.next = NULL;
+					queue = PianoListAppendP (queue, add);
+				}
+			}
+			if (song % 10 == 0) {
+				ok = ok && BenchSessionCall (b, &req, types[2], response[2],
+						length[2]);
+			}
+			if (song % 50 == 0) {
+				ok = ok && BenchSessionCall (b, &req, types[3], response[3],
+						length[3]);
+				FixtureFree (b, types[3]);
+			}
+
+			/* played */
+			PianoSong_t * const played = queue;
+			if (played != NULL) {
+				queue = (PianoSong_t *) played->head.next;
+				played->head.next = NULL;
+				PianoDestroyPlaylist (played);
+			}
+		}
+		PianoDestroyPlaylist (queue);
+		FixtureClearStations (&b->ph);
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+	} while (ok && r.ns < BENCH_TIME_NS);
+	PianoDestroyRequest (&req);
+
+	if (!ok) {
+		fprintf (stderr, "session: failed\n");
+		return false;
+	}
+	/* free-B is what the session left free inside the heap, fragmented */
+	printf ("BenchmarkSession/24h\t%llu\t%.1f ns/op\t%llu B/op\t"
+			"%llu allocs/op\t%zu peak-B\t%zd retained-B\t%zd free-B\n",
+			r.n, (double) r.ns / r.n, r.bytes / r.n, r.allocs / r.n,
+			benchPeak - live, (ssize_t) (benchLive - live),
+			(ssize_t) (mallinfo2 ().fordblks - heapFree));
+	fflush (stdout);
+	return true;
+}
+
+/*	build a list of n songs, appending to the bare list (walks to the tail
+ *	every time) or pushing to the tracked one
+ */
+static void BenchList (const char * const name, PianoSong_t * const songs,
+		const size_t n, const bool push) {
+	BenchResult_t r;
+
+	memset (&r, 0, sizeof (r));
+	do {
+		PianoSong_t *list = NULL;
+		PianoList_t tracked;
+
+		for (size_t i = 0; i < n; i++) {
+			songs[i].head.next = NULL;
+		}
+
+		const unsigned long long allocs = benchAllocs, bytes = benchBytes;
+		const uint64_t start = BenchNow ();
+		if (push) {
+			PianoListInit (&tracked, NULL);
+			for (size_t i = 0; i < n; i++) {
+				list = PianoListPushP (&tracked, &songs[i]);
+			}
+		} else {
+			for (size_t i = 0; i < n; i++) {
+				list = PianoListAppendP (list, &songs[i]);
+			}
+		}
+		r.ns += BenchNow () - start;
+		r.allocs += benchAllocs - allocs;
+		r.bytes += benchBytes - bytes;
+		++r.n;
+
+		assert (list == &songs[0]);
+	} while (r.ns < BENCH_TIME_NS);
+
+	BenchPrint ("List", name, &r);
+}
+
+int main (int argc, char **argv) {
+	const char * const dir = argc > 1 ? argv[1] : "test/corpus";
+	const char * const filter = argc > 2 ? argv[2] : "";
+	const size_t count = fixtureTypeCount;
+	char ** const responses = calloc (count, sizeof (*responses));
+	size_t * const lengths = calloc (count, sizeof (*lengths));
+	Fixture_t b;
+	int ret = EXIT_SUCCESS;
+
+	if (responses == NULL || lengths == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	/* everything is read first */
+	for (size_t i = 0; i < count; i++) {
+		char path[1024];
+		snprintf (path, sizeof (path), "%s/%s.json", dir, fixtureTypes[i].name);
+		responses[i] = BenchSlurp (path, &lengths[i]);
+		if (responses[i] == NULL) {
+			fprintf (stderr, "cannot read %s\n", path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	memset (&b, 0, sizeof (b));
+	if (PianoInit (&b.ph, BENCH_PARTNER_USER, BENCH_PARTNER_PASSWORD,
+			BENCH_DEVICE, BENCH_DECRYPT, BENCH_ENCRYPT) != PIANO_RET_OK) {
+		fprintf (stderr, "cannot initialize handle\n");
+		return EXIT_FAILURE;
+	}
+
+	/* login responses run first, requests need the tokens they set */
+	for (size_t i = 0; i < count; i++) {
+		if (strstr (fixtureTypes[i].name, filter) == NULL &&
+				fixtureTypes[i].type != PIANO_REQUEST_LOGIN) {
+			continue;
+		}
+		if (!BenchResponse (&b, &fixtureTypes[i], responses[i], lengths[i])) {
+			ret = EXIT_FAILURE;
+		}
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (strstr (fixtureTypes[i].name, filter) != NULL &&
+				!BenchRequest (&b, &fixtureTypes[i])) {
+			ret = EXIT_FAILURE;
+		}
+	}
+	/* body encryption of the authenticated requests */
+	for (size_t i = 0; i < count; i++) {
+		const FixtureType_t * const t = &fixtureTypes[i];
+		if (strstr (t->name, filter) == NULL ||
+				t->type == PIANO_REQUEST_LOGIN ||
+				t->type == PIANO_REQUEST_RATE_SONG) {
+			continue;
+		}
+		if (!BenchEncrypt (&b, t, true) || !BenchEncrypt (&b, t, false)) {
+			ret = EXIT_FAILURE;
+		}
+	}
+
+	if (strstr ("session", filter) != NULL &&
+			!BenchSession (&b, responses, lengths)) {
+		ret = EXIT_FAILURE;
+	}
+
+	/* long lists, appending used to be quadratic */
+	static const FixtureType_t feedback = {"get_station_info_5000",
+			PIANO_REQUEST_GET_STATION_INFO, 0};
+	if (strstr (feedback.name, filter) != NULL) {
+		size_t length;
+		char * const response = BenchFeedbackResponse (BENCH_FEEDBACK,
+				&length);
+		if (response == NULL ||
+				!BenchResponse (&b, &feedback, response, length) ||
+				!BenchResponseBefore ("get_station_info_5000/before",
+				response)) {
+			ret = EXIT_FAILURE;
+		}
+		free (response);
+	}
+	PianoSong_t * const songs = calloc (BENCH_FEEDBACK, sizeof (*songs));
+	if (songs == NULL) {
+		return EXIT_FAILURE;
+	}
+	if (strstr ("append_5000", filter) != NULL) {
+		BenchList ("append_5000", songs, BENCH_FEEDBACK, false);
+	}
+	if (strstr ("push_5000", filter) != NULL) {
+		BenchList ("push_5000", songs, BENCH_FEEDBACK, true);
+	}
+	free (songs);
+
+	for (unsigned int i = 0; i < 2; i++) {
+		if (!BenchBlowfish (filter, i == 1)) {
+			ret = EXIT_FAILURE;
+		}
+	}
+	for (unsigned int i = 0; i < 2; i++) {
+		if (!BenchHex (filter, i == 1, true, PIANO_HEX_KERNEL_SCALAR)) {
+			ret = EXIT_FAILURE;
+		}
+		for (PianoHexKernel_t k = PIANO_HEX_KERNEL_SCALAR;
+				k <= PIANO_HEX_KERNEL_AVX2; k++) {
+			if (!BenchHex (filter, i == 1, false, k)) {
+				ret = EXIT_FAILURE;
+			}
+		}
+	}
+
+	PianoDestroy (&b.ph);
+	for (size_t i = 0; i < count; i++) {
+		free (responses[i]);
+	}
+	free (responses);
+	free (lengths);
+
+	return ret;
+}
@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "piano.h"
+#include "piano_private.h"
+#include "fixture.h"
+
+const FixtureType_t fixtureTypes[] = {
+	{"login_partner", PIANO_REQUEST_LOGIN, 0},
+	{"login_user", PIANO_REQUEST_LOGIN, 1},
+	{"get_stations", PIANO_REQUEST_GET_STATIONS, 0},
+	{"get_playlist", PIANO_REQUEST_GET_PLAYLIST, 0},
+	{"rate_song", PIANO_REQUEST_RATE_SONG, 0},
+	/* low-level, its response is parsed as rate_song’s */
+	{"add_feedback", PIANO_REQUEST_ADD_FEEDBACK, 0},
+	{"rename_station", PIANO_REQUEST_RENAME_STATION, 0},
+	{"delete_station", PIANO_REQUEST_DELETE_STATION, 0},
+	{"search", PIANO_REQUEST_SEARCH, 0},
+	{"create_station", PIANO_REQUEST_CREATE_STATION, 0},
+	{"add_seed", PIANO_REQUEST_ADD_SEED, 0},
+	{"add_tired_song", PIANO_REQUEST_ADD_TIRED_SONG, 0},
+	{"set_quickmix", PIANO_REQUEST_SET_QUICKMIX, 0},
+	{"get_genre_stations", PIANO_REQUEST_GET_GENRE_STATIONS, 0},
+	{"transform_station", PIANO_REQUEST_TRANSFORM_STATION, 0},
+	{"explain", PIANO_REQUEST_EXPLAIN, 0},
+	{"bookmark_song", PIANO_REQUEST_BOOKMARK_SONG, 0},
+	{"bookmark_artist", PIANO_REQUEST_BOOKMARK_ARTIST, 0},
+	{"get_station_info", PIANO_REQUEST_GET_STATION_INFO, 0},
+	{"delete_feedback", PIANO_REQUEST_DELETE_FEEDBACK, 0},
+	{"delete_seed", PIANO_REQUEST_DELETE_SEED, 0},
+	{"get_settings", PIANO_REQUEST_GET_SETTINGS, 0},
+	{"change_settings", PIANO_REQUEST_CHANGE_SETTINGS, 0},
+};
+
+const size_t fixtureTypeCount = sizeof (fixtureTypes)/sizeof (*fixtureTypes);
+
+/*	remove all stations from the handle
+ */
+void FixtureClearStations (PianoHandle_t * const ph) {
+	PianoDestroyStations (ph->stations);
+	ph->stations = NULL;
+	ph->stationCount = 0;
+	free (ph->stationIndex.slots);
+	memset (&ph->stationIndex, 0, sizeof (ph->stationIndex));
+}
+
+/*	get request data for t, reset to the same state every time
+ */
+void *FixtureData (Fixture_t * const b, const FixtureType_t * const t) {
+	static char stationName[] = "Station", stationId[] = "4242424242",
+			seedId[] = "424242424242424242", trackToken[] =
+			"0123456789abcdef0123456789abcdef424242424242",
+			musicId[] = "R4242", feedbackId[] = "424242424242424242",
+			user[] = "listener@example.com", password[] = "secret",
+			newName[] = "Renamed station", searchStr[] = "artist";
+
+	memset (&b->station, 0, sizeof (b->station));
+	b->station.name = stationName;
+	b->station.id = stationId;
+	b->station.seedId = seedId;
+	memset (&b->song, 0, sizeof (b->song));
+	b->song.stationId = stationId;
+	b->song.trackToken = trackToken;
+	b->song.seedId = seedId;
+	b->song.feedbackId = feedbackId;
+	memset (&b->artist, 0, sizeof (b->artist));
+	b->artist.seedId = seedId;
+
+	switch (t->type) {
+		case PIANO_REQUEST_LOGIN:
+			b->login.user = user;
+			b->login.password = password;
+			b->login.step = t->step;
+			return &b->login;
+
+		case PIANO_REQUEST_GET_PLAYLIST:
+			b->playlist.station = &b->station;
+			b->playlist.quality = PIANO_AQ_HIGH;
+			b->playlist.retPlaylist = NULL;
+			return &b->playlist;
+
+		case PIANO_REQUEST_RATE_SONG:
+			b->rate.song = &b->song;
+			b->rate.rating = PIANO_RATE_LOVE;
+			return &b->rate;
+
+		case PIANO_REQUEST_ADD_FEEDBACK:
+			b->feedback.stationId = stationId;
+			b->feedback.trackToken = trackToken;
+			b->feedback.rating = PIANO_RATE_BAN;
+			return &b->feedback;
+
+		case PIANO_REQUEST_RENAME_STATION:
+			b->station.name = strdup (stationName);
+			b->rename.station = &b->station;
+			b->rename.newName = newName;
+			return &b->rename;
+
+		case PIANO_REQUEST_DELETE_STATION: {
+			/* freed by the response */
+			PianoStation_t * const station = calloc (1, sizeof (*station));
+			station->name = strdup (stationName);
+			station->id = strdup (stationId);
+			b->ph.stations = PianoListAppendP (b->ph.stations, station);
+			++b->ph.stationCount;
+			PianoStationIndexAdd (&b->ph, station);
+			return station;
+		}
+
+		case PIANO_REQUEST_SEARCH:
+			memset (&b->search, 0, sizeof (b->search));
+			b->search.searchStr = searchStr;
+			return &b->search;
+
+		case PIANO_REQUEST_CREATE_STATION:
+			b->create.token = trackToken;
+			b->create.type = PIANO_MUSICTYPE_SONG;
+			return &b->create;
+
+		case PIANO_REQUEST_ADD_SEED:
+			b->seed.station = &b->station;
+			b->seed.musicId = musicId;
+			return &b->seed;
+
+		case PIANO_REQUEST_EXPLAIN:
+			b->explain.song = &b->song;
+			b->explain.retExplain = NULL;
+			return &b->explain;
+
+		case PIANO_REQUEST_GET_STATION_INFO:
+			memset (&b->info, 0, sizeof (b->info));
+			b->info.station = &b->station;
+			return &b->info;
+
+		case PIANO_REQUEST_DELETE_SEED:
+			memset (&b->deleteSeed, 0, sizeof (b->deleteSeed));
+			b->deleteSeed.artist = &b->artist;
+			return &b->deleteSeed;
+
+		case PIANO_REQUEST_GET_SETTINGS:
+			memset (&b->settings, 0, sizeof (b->settings));
+			return &b->settings;
+
+		case PIANO_REQUEST_CHANGE_SETTINGS:
+			memset (&b->changeSettings, 0, sizeof (b->changeSettings));
+			b->changeSettings.currentUsername = user;
+			b->changeSettings.currentPassword = password;
+			b->changeSettings.explicitContentFilter = PIANO_TRUE;
+			return &b->changeSettings;
+
+		case PIANO_REQUEST_ADD_TIRED_SONG:
+		case PIANO_REQUEST_TRANSFORM_STATION:
+		case PIANO_REQUEST_BOOKMARK_SONG:
+		case PIANO_REQUEST_BOOKMARK_ARTIST:
+		case PIANO_REQUEST_DELETE_FEEDBACK:
+			return t->type == PIANO_REQUEST_TRANSFORM_STATION ?
+					(void *) &b->station : (void *) &b->song;
+
+		default:
+			return NULL;
+	}
+}
+
+/*	free whatever PianoResponse returned for t
+ */
+void FixtureFree (Fixture_t * const b, const FixtureType_t * const t) {
+	switch (t->type) {
+		case PIANO_REQUEST_GET_STATIONS:
+			FixtureClearStations (&b->ph);
+			break;
+
+		case PIANO_REQUEST_GET_PLAYLIST:
+			PianoDestroyPlaylist (b->playlist.retPlaylist);
+			break;
+
+		case PIANO_REQUEST_RENAME_STATION:
+			free (b->station.name);
+			break;
+
+		case PIANO_REQUEST_SEARCH:
+			PianoDestroySearchResult (&b->search.searchResult);
+			break;
+
+		case PIANO_REQUEST_GET_GENRE_STATIONS:
+			PianoDestroyGenreCategories (b->ph.genreStations);
+			b->ph.genreStations = NULL;
+			break;
+
+		case PIANO_REQUEST_EXPLAIN:
+			free (b->explain.retExplain);
+			break;
+
+		case PIANO_REQUEST_GET_STATION_INFO:
+			PianoDestroyStationInfo (&b->info.info);
+			break;
+
+		case PIANO_REQUEST_GET_SETTINGS:
+			free (b->settings.username);
+			break;
+
+		default:
+			break;
+	}
+}
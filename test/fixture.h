@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* request data of every type for the benchmark and the checks */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "piano.h"
+
+/* request type plus login step, named like its response in test/corpus */
+typedef struct {
+	const char *name;
+	PianoRequestType_t type;
+	unsigned char step;
+} FixtureType_t;
+
+/* request data of every type, set up by FixtureData */
+typedef struct {
+	PianoHandle_t ph;
+	PianoStation_t station;
+	PianoSong_t song;
+	PianoArtist_t artist;
+	PianoRequestDataLogin_t login;
+	PianoRequestDataGetPlaylist_t playlist;
+	PianoRequestDataRateSong_t rate;
+	PianoRequestDataAddFeedback_t feedback;
+	PianoRequestDataRenameStation_t rename;
+	PianoRequestDataSearch_t search;
+	PianoRequestDataCreateStation_t create;
+	PianoRequestDataAddSeed_t seed;
+	PianoRequestDataExplain_t explain;
+	PianoRequestDataGetStationInfo_t info;
+	PianoRequestDataDeleteSeed_t deleteSeed;
+	PianoSettings_t settings;
+	PianoRequestDataChangeSettings_t changeSettings;
+} Fixture_t;
+
+extern const FixtureType_t fixtureTypes[];
+extern const size_t fixtureTypeCount;
+
+void FixtureClearStations (PianoHandle_t * const);
+void *FixtureData (Fixture_t * const, const FixtureType_t * const);
+void FixtureFree (Fixture_t * const, const FixtureType_t * const);
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* wakeups, cpu time and song end latency of the main loop’s wait, before
+ * (console read with a one second timeout) and after (BarLoopTimeout). The
+ * console is a pipe nobody writes to, the player a clock playing short
+ * songs back to back. Prints lines in the format of Go’s benchmarks:
+ *
+ *   BenchmarkIdle/paused/before  1  60.0 wakeups/min  5.1 cpu-us/min
+ *
+ *   idle [seconds per case] */
+
+#include "config.h"
+
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "loop.h"
+
+/* the old console read timeout */
+#define IDLE_BEFORE_TIMEOUT 1000
+
+/* stopped (no station) waits like paused */
+typedef enum {
+	IDLE_PLAYING = 0,
+	IDLE_PAUSED,
+} IdleState_t;
+
+static const char * const idleStateNames[] = {"playing", "paused"};
+
+/* songs played back to back, seconds */
+static const double idleSongs[] = {2.35, 3.71, 1.93};
+
+static uint64_t IdleNow (void) {
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t IdleCpu (void) {
+	struct rusage usage;
+	getrusage (RUSAGE_SELF, &usage);
+	return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+			1000000ull + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+/*	run the loop for the given time
+ */
+static void IdleRun (const int fd, const IdleState_t state, const bool after,
+		const unsigned int seconds) {
+	const uint64_t start = IdleNow (), cpu = IdleCpu (),
+			deadline = start + seconds * 1000000000ull;
+	uint64_t songStart = start;
+	unsigned long long wakeups = 0, ends = 0, latency = 0;
+	size_t song = 0;
+
+	while (true) {
+		const uint64_t now = IdleNow ();
+		const double played = (now - songStart) / 1e9;
+		const double duration = idleSongs[song];
+		unsigned long timeout;
+		bool songEnd;
+
+		if (now >= deadline) {
+			break;
+		}
+
+		if (state == IDLE_PLAYING && played >= duration) {
+			/* noticed the end, next song */
+			latency += (now - songStart) / 1000 -
+					(uint64_t) (duration * 1000000);
+			++ends;
+			song = (song + 1) % (sizeof (idleSongs)/sizeof (*idleSongs));
+			songStart = now;
+			continue;
+		}
+
+		timeout = after ? BarLoopTimeout (state == IDLE_PLAYING,
+				state != IDLE_PLAYING, played, duration, &songEnd) :
+				IDLE_BEFORE_TIMEOUT;
+		/* the end of the run does not count as a wakeup */
+		const unsigned long left = (deadline - now + 999999) / 1000000;
+		const bool last = timeout == BAR_LOOP_INFINITE || timeout >= left;
+
+		struct pollfd pfd = {.fd = fd, .events = POLLIN};
+		poll (&pfd, 1, last ? (int) left : (int) timeout);
+		if (!last) {
+			++wakeups;
+		}
+	}
+
+	const double minutes = (IdleNow () - start) / 60e9;
+	printf ("BenchmarkIdle/%s/%s\t1\t%.1f wakeups/min\t%.1f cpu-us/min",
+			idleStateNames[state], after ? "after" : "before",
+			wakeups / minutes, (IdleCpu () - cpu) / minutes);
+	if (state == IDLE_PLAYING) {
+		printf ("\t%.1f end-latency-ms", ends > 0 ?
+				latency / 1000.0 / ends : 0.0);
+	}
+	printf ("\n");
+	fflush (stdout);
+}
+
+int main (int argc, char **argv) {
+	const unsigned int seconds = argc > 1 ? atoi (argv[1]) : 10;
+	int fds[2];
+
+	if (seconds == 0 || pipe (fds) != 0) {
+		fprintf (stderr, "usage: %s [seconds per case]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	for (IdleState_t state = IDLE_PLAYING; state <= IDLE_PAUSED; state++) {
+		IdleRun (fds[0], state, false, seconds);
+		IdleRun (fds[0], state, true, seconds);
+	}
+
+	close (fds[0]);
+	close (fds[1]);
+	return EXIT_SUCCESS;
+}
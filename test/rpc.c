@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2008-2017
+	Lars-Dominik Braun <lars@6xq.net>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* drives libpiano over the POSIX transport (http_posix.c) the way pianobar
+ * does: logs in, fetches the station list and prints it along with the
+ * transport’s counters.
+ *
+ *   rpc user password [host [tls port [ca bundle]]] */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piano.h"
+#include "http/http.h"
+
+/* keys of the android partner, see contrib/pianobar.1 */
+#define RPC_PARTNER_USER "android"
+#define RPC_PARTNER_PASSWORD "AC7IBG09A3DTSYM4R41UJWL07VLN8JI7"
+#define RPC_DEVICE "android-generic"
+#define RPC_DECRYPT "R=U!LH$O2B#"
+#define RPC_ENCRYPT "6#26FRL$ZWD"
+#define RPC_HOST "tuner.pandora.com"
+#define RPC_TLS_PORT "443"
+#define RPC_TIMEOUT 30
+
+static http_t rpcHttp;
+
+static PianoReturn_t RpcReceive (PianoRequest_t *req) {
+	bool done;
+
+	if (!HttpRequestReceive (rpcHttp, req, &done)) {
+		return PIANO_RET_NETWORK_ERROR;
+	}
+	return done ? PIANO_RET_OK : PIANO_RET_CONTINUE_REQUEST;
+}
+
+/*	run all http requests of one call, parsing responses while they are
+ *	received
+ *	@return PIANO_RET_OK or the error
+ */
+static PianoReturn_t RpcCall (PianoHandle_t * const ph,
+		PianoRequest_t * const req, const PianoRequestType_t type,
+		void * const data) {
+	PianoReturn_t ret;
+
+	do {
+		req->data = data;
+		if ((ret = PianoRequest (ph, req, type)) != PIANO_RET_OK) {
+			break;
+		}
+		if (HttpRequestBegin (rpcHttp, req)) {
+			req->receive = RpcReceive;
+			ret = PianoResponse (ph, req);
+			req->receive = NULL;
+		} else {
+			ret = PIANO_RET_NETWORK_ERROR;
+		}
+		if (ret == PIANO_RET_NETWORK_ERROR) {
+			fprintf (stderr, "Network error: %s\n", HttpGetError (rpcHttp));
+		}
+	} while (ret == PIANO_RET_CONTINUE_REQUEST);
+
+	PianoResetRequest (req);
+	return ret;
+}
+
+int main (int argc, char **argv) {
+	PianoHandle_t ph;
+	PianoRequest_t req;
+	PianoRequestDataLogin_t login;
+	PianoReturn_t ret;
+	HttpStats_t stats;
+
+	if (argc < 3) {
+		fprintf (stderr, "usage: %s user password [host [tls port "
+				"[ca bundle]]]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!HttpInit (&rpcHttp, argc > 3 ? argv[3] : RPC_HOST,
+			argc > 4 ? argv[4] : RPC_TLS_PORT, RPC_TIMEOUT)) {
+		fprintf (stderr, "cannot initialize transport\n");
+		return EXIT_FAILURE;
+	}
+	if (argc > 5 && !HttpSetCaBundle (rpcHttp, argv[5])) {
+		fprintf (stderr, "%s\n", HttpGetError (rpcHttp));
+		return EXIT_FAILURE;
+	}
+	if (PianoInit (&ph, RPC_PARTNER_USER, RPC_PARTNER_PASSWORD, RPC_DEVICE,
+			RPC_DECRYPT, RPC_ENCRYPT) != PIANO_RET_OK) {
+		fprintf (stderr, "cannot initialize handle\n");
+		return EXIT_FAILURE;
+	}
+	memset (&req, 0, sizeof (req));
+
+	login.user = argv[1];
+	login.password = argv[2];
+	login.step = 0;
+	if ((ret = RpcCall (&ph, &req, PIANO_REQUEST_LOGIN, &login)) ==
+			PIANO_RET_OK) {
+		ret = RpcCall (&ph, &req, PIANO_REQUEST_GET_STATIONS, NULL);
+	}
+
+	if (ret == PIANO_RET_OK) {
+		const PianoStation_t *station = ph.stations;
+		PianoListForeachP (station) {
+			printf ("%s\t%s\n", station->id, station->name);
+		}
+		printf ("%zu stations\n", ph.stationCount);
+	} else {
+		fprintf (stderr, "Error: %s\n", PianoErrorToStr (ret));
+	}
+
+	HttpGetStats (rpcHttp, &stats);
+	printf ("%lu requests, %lu connects (%lu reused), %lu handshakes "
+			"(%lu resumed), %llu bytes received, %llu decoded\n",
+			stats.requests, stats.connects, stats.reused, stats.handshakes,
+			stats.resumed, stats.received, stats.decoded);
+
+	free (req.responseData);
+	PianoDestroyRequest (&req);
+	PianoDestroy (&ph);
+	HttpDestroy (rpcHttp);
+
+	return ret == PIANO_RET_OK ? EXIT_SUCCESS : EXIT_FAILURE;
+}
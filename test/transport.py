@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+# Stand-in for the tuner server, used by test/transport.c to exercise the
+# POSIX transport (src/http/http_posix.c): framing, content encodings,
+# retries, timeouts, TLS session resumption and a CONNECT proxy.
+#
+#   transport.py plain-port tls-port proxy-port certificate key
+#
+# The response depends on the last path component only:
+#
+#   length, chunked, eof   small body, framed by Content-Length, chunked or
+#                          closing the connection
+#   close                  like length, then closes the connection
+#   large, large-chunked   multi-megabyte body
+#   gzip, gzip-chunked, zlib, deflate
+#                          the large body compressed (deflate is raw deflate
+#                          without zlib header, as some servers send it)
+#   corrupt, truncated     broken gzip stream, half of it
+#   retry                  503 on every other request, 200 otherwise
+#   unavailable            always 503
+#   slow                   answers after SLOW_DELAY seconds
+#   hits-<name>            requests seen for <name> so far
+#
+# The proxy port accepts CONNECT to the tls port only, with user:p@ss.
+
+import gzip
+import socket
+import ssl
+import sys
+import threading
+import time
+import zlib
+
+SLOW_DELAY = 3
+PROXY_AUTH = 'Proxy-Authorization: Basic dXNlcjpwQHNz'
+
+SMALL = (b'{"stat":"ok","result":{"stations":[' + b','.join(
+		b'{"stationName":"Station %d","stationId":"%d"}' % (i, i)
+		for i in range(16)) + b']}}')
+LARGE = (b'{"stat":"ok","result":{"stations":[' + b','.join(
+		b'{"stationName":"Station %d","stationId":"%d","isShared":false}' %
+		(i, i) for i in range(80000)) + b']}}')
+
+
+def rawDeflate(data):
+	compressor = zlib.compressobj(6, zlib.DEFLATED, -zlib.MAX_WBITS)
+	return compressor.compress(data) + compressor.flush()
+
+
+GZIP = gzip.compress(LARGE)
+ENCODED = {
+	'gzip': (b'gzip', GZIP),
+	'zlib': (b'deflate', zlib.compress(LARGE)),
+	'deflate': (b'deflate', rawDeflate(LARGE)),
+	'corrupt': (b'gzip', GZIP[:1000] + b'garbage' * 64 + GZIP[1448:]),
+	'truncated': (b'gzip', GZIP[:len(GZIP) // 2]),
+}
+
+hits = {}
+hitsLock = threading.Lock()
+
+
+def chunked(data, size):
+	out = [b'%x\r\n%s\r\n' % (len(data[i:i + size]), data[i:i + size])
+			for i in range(0, len(data), size)]
+	return b''.join(out) + b'0\r\n\r\n'
+
+
+def respond(name, body):
+	""" response for name and whether the connection stays open """
+	if name.startswith('hits-'):
+		with hitsLock:
+			body = b'{"hits":%d}' % hits.get(name[5:], 0)
+		return b'HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s' % (
+				len(body), body), True
+
+	with hitsLock:
+		hits[name] = count = hits.get(name, 0) + 1
+
+	if name == 'length':
+		return b'HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s' % (
+				len(SMALL), SMALL), True
+	elif name == 'close':
+		return (b'HTTP/1.1 200 OK\r\nConnection: close\r\n'
+				b'Content-Length: %d\r\n\r\n%s' % (len(SMALL), SMALL)), False
+	elif name == 'chunked':
+		return (b'HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n' +
+				chunked(SMALL, 7)), True
+	elif name == 'eof':
+		return b'HTTP/1.0 200 OK\r\n\r\n' + SMALL, False
+	elif name == 'large':
+		return b'HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s' % (
+				len(LARGE), LARGE), True
+	elif name == 'large-chunked':
+		return (b'HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n' +
+				chunked(LARGE, 8000)), True
+	elif name == 'gzip-chunked':
+		return (b'HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\n'
+				b'Transfer-Encoding: chunked\r\n\r\n' + chunked(GZIP, 3000)), True
+	elif name in ENCODED:
+		encoding, data = ENCODED[name]
+		return (b'HTTP/1.1 200 OK\r\nContent-Encoding: %s\r\n'
+				b'Content-Length: %d\r\n\r\n%s' % (encoding, len(data), data)), True
+	elif name == 'retry' and count % 2 == 1 or name == 'unavailable':
+		return (b'HTTP/1.1 503 Service Unavailable\r\n'
+				b'Content-Length: 0\r\n\r\n'), True
+	elif name == 'slow':
+		time.sleep(SLOW_DELAY)
+	body = b'{"stat":"ok","echo":"%s"}' % body
+	return b'HTTP/1.1 200 OK\r\nContent-Length: %d\r\n\r\n%s' % (
+			len(body), body), True
+
+
+def readHeaders(reader):
+	headers = []
+	while True:
+		line = reader.readline()
+		if line in (b'\r\n', b''):
+			return headers
+		headers.append(line.decode().strip())
+
+
+def pump(source, destination):
+	try:
+		while True:
+			data = source.recv(65536)
+			if not data:
+				break
+			destination.sendall(data)
+	except OSError:
+		pass
+	try:
+		destination.shutdown(socket.SHUT_WR)
+	except OSError:
+		pass
+
+
+def proxy(client, tlsPort):
+	reader = client.makefile('rb')
+	request = reader.readline().decode().split()
+	headers = readHeaders(reader)
+	if request[:2] != ['CONNECT', 'localhost:%d' % tlsPort]:
+		client.sendall(b'HTTP/1.1 403 Forbidden\r\nContent-Length: 0\r\n\r\n')
+	elif PROXY_AUTH not in headers:
+		client.sendall(b'HTTP/1.1 407 Proxy Authentication Required\r\n'
+				b'Content-Length: 0\r\n\r\n')
+	else:
+		client.sendall(b'HTTP/1.1 200 Connection established\r\n\r\n')
+		upstream = socket.create_connection(('127.0.0.1', tlsPort))
+		thread = threading.Thread(target=pump, args=(upstream, client))
+		thread.start()
+		pump(client, upstream)
+		thread.join()
+		upstream.close()
+	client.close()
+
+
+def serve(client):
+	reader = client.makefile('rb')
+	try:
+		while True:
+			request = reader.readline().decode().split()
+			if not request:
+				break
+			length = 0
+			for header in readHeaders(reader):
+				name, value = header.split(':', 1)
+				if name.lower() == 'content-length':
+					length = int(value)
+			body = reader.read(length)
+			name = request[1].split('?')[0].split('/')[-1]
+			response, keepAlive = respond(name, body)
+			client.sendall(response)
+			if not keepAlive:
+				if isinstance(client, ssl.SSLSocket):
+					# close_notify, or the end of the body looks truncated
+					client = client.unwrap()
+				break
+	except (OSError, ssl.SSLError):
+		pass
+	client.close()
+
+
+def listen(port, handler, context=None):
+	server = socket.socket()
+	server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+	server.bind(('127.0.0.1', port))
+	server.listen(16)
+
+	def accept():
+		while True:
+			client, _ = server.accept()
+			if context:
+				try:
+					client = context.wrap_socket(client, server_side=True)
+				except (OSError, ssl.SSLError):
+					client.close()
+					continue
+			threading.Thread(target=handler, args=(client,), daemon=True).start()
+
+	threading.Thread(target=accept, daemon=True).start()
+
+
+def main():
+	if len(sys.argv) != 6:
+		sys.exit('usage: %s plain-port tls-port proxy-port certificate key' %
+				sys.argv[0])
+	plainPort, tlsPort, proxyPort = (int(port) for port in sys.argv[1:4])
+
+	context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+	context.load_cert_chain(sys.argv[4], sys.argv[5])
+
+	listen(plainPort, serve)
+	listen(tlsPort, serve, context)
+	listen(proxyPort, lambda client: proxy(client, tlsPort))
+	while True:
+		time.sleep(60)
+
+
+if __name__ == '__main__':
+	main()